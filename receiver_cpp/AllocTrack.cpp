@@ -0,0 +1,210 @@
+#include "AllocTrack.hpp"
+
+#if RECEIVER_ALLOC_TRACKING
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <intrin.h>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#ifdef _DEBUG
+#include <crtdbg.h>
+#endif
+
+// Everything here runs inside operator new, so it must not allocate:
+// fixed tables, thread_local PODs and relaxed atomics only.
+namespace {
+
+constexpr int kThreads = 128;
+constexpr int kSites   = 1024;   // power of two
+
+struct ThreadSlot {
+    std::atomic<std::uint64_t> allocs{0}, bytes{0}, frees{0};
+    DWORD                      tid = 0;
+    const char*                name = nullptr;
+};
+
+struct Site {
+    std::atomic<void*>         addr{nullptr};
+    std::atomic<std::uint64_t> count{0};
+};
+
+ThreadSlot             g_threads[kThreads + 1];   // last slot: overflow
+std::atomic<int>       g_threadCount{0};
+Site                   g_sites[kSites];
+std::atomic<std::uint64_t> g_warmup{0};
+std::atomic<bool>      g_dirty{false};
+
+thread_local ThreadSlot* t_slot = nullptr;
+thread_local bool        t_inNew = false;
+
+ThreadSlot& slot() {
+    if (!t_slot) {
+        int i = g_threadCount.fetch_add(1, std::memory_order_relaxed);
+        t_slot = &g_threads[i < kThreads ? i : kThreads];
+        if (i < kThreads) t_slot->tid = GetCurrentThreadId();
+    }
+    return *t_slot;
+}
+
+void countAlloc(std::size_t n) {
+    ThreadSlot& s = slot();
+    s.allocs.fetch_add(1, std::memory_order_relaxed);
+    s.bytes.fetch_add(n, std::memory_order_relaxed);
+}
+
+void countSite(void* ret) {
+    std::size_t h = ((std::uintptr_t)ret >> 4) * 0x9E3779B97F4A7C15ull;
+    for (int probe = 0; probe < kSites; ++probe) {
+        Site& s = g_sites[(h + probe) & (kSites - 1)];
+        void* cur = s.addr.load(std::memory_order_relaxed);
+        if (!cur && s.addr.compare_exchange_strong(cur, ret, std::memory_order_relaxed)) cur = ret;
+        if (cur == ret) { s.count.fetch_add(1, std::memory_order_relaxed); return; }
+    }
+}
+
+void* trackedNew(std::size_t n, void* ret, bool nothrow) {
+    t_inNew = true;   // the debug CRT hook must not count this one again
+    countAlloc(n);
+    countSite(ret);
+    void* p = std::malloc(n ? n : 1);
+    t_inNew = false;
+    if (!p && !nothrow) throw std::bad_alloc();
+    return p;
+}
+
+void* trackedAlignedNew(std::size_t n, std::align_val_t a, void* ret, bool nothrow) {
+    t_inNew = true;   // same as trackedNew
+    countAlloc(n);
+    countSite(ret);
+    void* p = _aligned_malloc(n ? n : 1, (std::size_t)a);
+    t_inNew = false;
+    if (!p && !nothrow) throw std::bad_alloc();
+    return p;
+}
+
+void trackedDelete(void* p) {
+    if (!p) return;
+    slot().frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+void trackedAlignedDelete(void* p) {
+    if (!p) return;
+    slot().frees.fetch_add(1, std::memory_order_relaxed);
+    _aligned_free(p);
+}
+
+#ifdef _DEBUG
+// Debug CRT: also see plain malloc/calloc/realloc (e.g. inside the CRT or C code).
+int __cdecl crtHook(int type, void*, std::size_t size, int blockType, long, const unsigned char*, int) {
+    if (blockType == _CRT_BLOCK || t_inNew) return TRUE;
+    if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) countAlloc(size);
+    return TRUE;
+}
+const bool g_hooked = (_CrtSetAllocHook(crtHook), true);
+#endif
+
+// "receiver.exe+0x1a2b3" — feed the offset to the .pdb (e.g. in a debugger).
+void printSite(void* addr, std::uint64_t count) {
+    HMODULE mod = nullptr;
+    char path[MAX_PATH] = "?";
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           static_cast<LPCSTR>(addr), &mod))
+        GetModuleFileNameA(mod, path, sizeof path);
+    const char* base = path;
+    for (const char* c = path; *c; ++c)
+        if (*c == '\\' || *c == '/') base = c + 1;
+    std::printf("[alloc]   %10llu  %s+0x%llx\n", (unsigned long long)count, base,
+                (unsigned long long)((std::uintptr_t)addr - (std::uintptr_t)mod));
+}
+
+} // namespace
+
+// ----- global replacements -----
+void* operator new(std::size_t n) { return trackedNew(n, _ReturnAddress(), false); }
+void* operator new[](std::size_t n) { return trackedNew(n, _ReturnAddress(), false); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return trackedNew(n, _ReturnAddress(), true); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return trackedNew(n, _ReturnAddress(), true); }
+void* operator new(std::size_t n, std::align_val_t a) { return trackedAlignedNew(n, a, _ReturnAddress(), false); }
+void* operator new[](std::size_t n, std::align_val_t a) { return trackedAlignedNew(n, a, _ReturnAddress(), false); }
+void* operator new(std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return trackedAlignedNew(n, a, _ReturnAddress(), true); }
+void* operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return trackedAlignedNew(n, a, _ReturnAddress(), true); }
+
+void operator delete(void* p) noexcept { trackedDelete(p); }
+void operator delete[](void* p) noexcept { trackedDelete(p); }
+void operator delete(void* p, std::size_t) noexcept { trackedDelete(p); }
+void operator delete[](void* p, std::size_t) noexcept { trackedDelete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedDelete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedDelete(p); }
+void operator delete(void* p, std::align_val_t) noexcept { trackedAlignedDelete(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { trackedAlignedDelete(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { trackedAlignedDelete(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { trackedAlignedDelete(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedAlignedDelete(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedAlignedDelete(p); }
+
+namespace alloctrack {
+
+Counters thisThread() {
+    ThreadSlot& s = slot();
+    return {s.allocs.load(std::memory_order_relaxed), s.bytes.load(std::memory_order_relaxed),
+            s.frees.load(std::memory_order_relaxed)};
+}
+
+void setWarmup(std::uint64_t iterations) { g_warmup.store(iterations); }
+
+bool steadyStateClean() { return !g_dirty.load(); }
+
+LoopCheck::LoopCheck(const char* name) : name_(name), warmup_(g_warmup.load()) {
+    slot().name = name;
+    if (!warmup_) warmup_ = UINT64_MAX;   // checks off
+}
+
+LoopCheck::~LoopCheck() {
+    if (iterations_ <= warmup_) {
+        if (warmup_ != UINT64_MAX)
+            std::printf("[alloc] %s: only %llu iterations, warm-up not reached\n", name_,
+                        (unsigned long long)iterations_);
+        return;
+    }
+    const std::uint64_t steady = thisThread().allocs - base_;
+    std::printf("[alloc] %s: %llu allocations in %llu iterations after %llu warm-up -> %s\n", name_,
+                (unsigned long long)steady, (unsigned long long)(iterations_ - warmup_),
+                (unsigned long long)warmup_, steady ? "FAIL" : "ok");
+    if (steady) g_dirty.store(true);
+}
+
+void report() {
+    int n = g_threadCount.load();
+    if (n > kThreads) n = kThreads + 1;
+    for (int i = 0; i < n; ++i) {
+        const ThreadSlot& s = g_threads[i];
+        std::printf("[alloc] thread %5lu %-10s %10llu allocs, %12llu bytes, %10llu frees\n",
+                    (unsigned long)s.tid, s.name ? s.name : "", (unsigned long long)s.allocs.load(),
+                    (unsigned long long)s.bytes.load(), (unsigned long long)s.frees.load());
+    }
+    // Top 10 operator new call sites (selection over the fixed table; no allocation).
+    bool shown[kSites] = {};
+    std::printf("[alloc] busiest operator new call sites:\n");
+    for (int k = 0; k < 10; ++k) {
+        int best = -1;
+        for (int i = 0; i < kSites; ++i)
+            if (!shown[i] && g_sites[i].addr.load() &&
+                (best < 0 || g_sites[i].count.load() > g_sites[best].count.load()))
+                best = i;
+        if (best < 0) break;
+        shown[best] = true;
+        printSite(g_sites[best].addr.load(), g_sites[best].count.load());
+    }
+}
+
+} // namespace alloctrack
+
+#endif // RECEIVER_ALLOC_TRACKING
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+
+// Heap allocation accounting, compiled in with the CMake option
+// RECEIVER_ALLOC_TRACKING. The build replaces the global operator new/delete
+// (and, with the debug CRT, hooks malloc) to count allocations per thread and
+// per call site.
+//
+// LoopCheck marks a hot loop: after 'warm-up' iterations, any allocation the
+// loop's thread makes is a steady-state allocation, reported at exit and
+// turned into a non-zero exit code by `receiver --alloc-check`.
+// Without the option everything below is an empty inline no-op.
+namespace alloctrack {
+
+struct Counters {
+    std::uint64_t allocs = 0;
+    std::uint64_t bytes  = 0;
+    std::uint64_t frees  = 0;
+};
+
+#if RECEIVER_ALLOC_TRACKING
+
+constexpr bool kCompiledIn = true;
+
+Counters thisThread();
+
+// Iterations each LoopCheck ignores before it starts counting (0 = no checks).
+void setWarmup(std::uint64_t iterations);
+
+// False once any LoopCheck saw an allocation after its warm-up.
+bool steadyStateClean();
+
+// Per-thread totals and the busiest operator new call sites.
+void report();
+
+class LoopCheck {
+public:
+    explicit LoopCheck(const char* name);
+    ~LoopCheck();
+    void tick() {
+        if (++iterations_ == warmup_) base_ = thisThread().allocs;
+    }
+
+private:
+    const char*   name_;
+    std::uint64_t warmup_;
+    std::uint64_t iterations_ = 0;
+    std::uint64_t base_ = 0;
+};
+
+#else
+
+constexpr bool kCompiledIn = false;
+
+inline Counters thisThread() { return {}; }
+inline void setWarmup(std::uint64_t) {}
+inline bool steadyStateClean() { return true; }
+inline void report() {}
+
+class LoopCheck {
+public:
+    explicit LoopCheck(const char*) {}
+    void tick() {}
+};
+
+#endif
+
+} // namespace alloctrack
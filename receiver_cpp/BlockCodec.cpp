@@ -0,0 +1,111 @@
+#include "BlockCodec.hpp"
+#include <cstring>
+
+namespace blockcodec {
+namespace {
+
+constexpr unsigned    kHashBits = 13;
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kMaxOffset = 65535;
+
+inline std::uint32_t read32(const std::uint8_t* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline std::uint32_t hash4(std::uint32_t v) {
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+inline std::uint8_t* putLength(std::uint8_t* op, std::size_t len) {
+    for (; len >= 255; len -= 255) *op++ = 255;
+    *op++ = (std::uint8_t)len;
+    return op;
+}
+
+std::uint8_t* putSequence(std::uint8_t* op, const std::uint8_t* lit, std::size_t litLen,
+                          std::size_t offset, std::size_t matchLen) {
+    std::uint8_t* token = op++;
+    std::size_t ml = matchLen ? matchLen - kMinMatch : 0;
+    *token = (std::uint8_t)(((litLen >= 15 ? 15 : litLen) << 4) | (ml >= 15 ? 15 : ml));
+    if (litLen >= 15) op = putLength(op, litLen - 15);
+    std::memcpy(op, lit, litLen);
+    op += litLen;
+    if (!matchLen) return op; // final literals-only sequence
+    *op++ = (std::uint8_t)offset;
+    *op++ = (std::uint8_t)(offset >> 8);
+    if (ml >= 15) op = putLength(op, ml - 15);
+    return op;
+}
+
+} // namespace
+
+std::size_t compress(const std::uint8_t* src, std::size_t n, std::uint8_t* dst) {
+    std::uint32_t table[1u << kHashBits];
+    std::memset(table, 0xFF, sizeof table); // 0xFFFFFFFF = empty slot
+
+    std::uint8_t* op = dst;
+    std::size_t anchor = 0, i = 0;
+    while (n >= kMinMatch && i + kMinMatch <= n) {
+        std::uint32_t v = read32(src + i);
+        std::uint32_t h = hash4(v);
+        std::uint32_t cand = table[h];
+        table[h] = (std::uint32_t)i;
+        if (cand == 0xFFFFFFFFu || i - cand > kMaxOffset || read32(src + cand) != v) {
+            ++i;
+            continue;
+        }
+        std::size_t len = kMinMatch;
+        while (i + len < n && src[cand + len] == src[i + len]) ++len;
+        op = putSequence(op, src + anchor, i - anchor, i - cand, len);
+        i += len;
+        anchor = i;
+    }
+    op = putSequence(op, src + anchor, n - anchor, 0, 0);
+    return (std::size_t)(op - dst);
+}
+
+bool decompress(const std::uint8_t* src, std::size_t n, std::uint8_t* dst, std::size_t rawLen) {
+    const std::uint8_t* ip = src;
+    const std::uint8_t* iend = src + n;
+    std::size_t o = 0;
+
+    while (ip < iend) {
+        std::uint8_t token = *ip++;
+        std::size_t lit = token >> 4;
+        if (lit == 15) {
+            std::uint8_t b;
+            do {
+                if (ip >= iend) return false;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > (std::size_t)(iend - ip) || lit > rawLen - o) return false;
+        std::memcpy(dst + o, ip, lit);
+        ip += lit;
+        o += lit;
+        if (ip == iend) break; // last sequence
+
+        if (iend - ip < 2) return false;
+        std::size_t off = ip[0] | (ip[1] << 8);
+        ip += 2;
+        std::size_t ml = token & 15;
+        if (ml == 15) {
+            std::uint8_t b;
+            do {
+                if (ip >= iend) return false;
+                b = *ip++;
+                ml += b;
+            } while (b == 255);
+        }
+        ml += kMinMatch;
+        if (off == 0 || off > o || ml > rawLen - o) return false;
+        // Byte-wise on purpose: overlapping matches (off < ml) replicate runs.
+        for (std::size_t k = 0; k < ml; ++k, ++o) dst[o] = dst[o - off];
+    }
+    return o == rawLen;
+}
+
+} // namespace blockcodec
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Small self-contained LZ77 codec (LZ4-style sequences) for capture blocks.
+// Telemetry payloads repeat a lot, so a greedy single-probe matcher gets most
+// of the gain at memcpy-like speed and without an external dependency.
+//
+// Sequence: token (hi nibble literal count, lo nibble match length - 4; 15 =
+// "more length bytes follow", each 255 = keep going), literals, u16 LE
+// offset, extra match length bytes. The last sequence has literals only.
+namespace blockcodec {
+
+// Worst-case compressed size for 'n' input bytes.
+constexpr std::size_t bound(std::size_t n) { return n + n / 255 + 16; }
+
+// Compress src[0..n) into dst (capacity >= bound(n)). Returns bytes written.
+std::size_t compress(const std::uint8_t* src, std::size_t n, std::uint8_t* dst);
+
+// Decompress exactly 'rawLen' bytes. Returns false on malformed input.
+bool decompress(const std::uint8_t* src, std::size_t n, std::uint8_t* dst, std::size_t rawLen);
+
+} // namespace blockcodec
@@ -0,0 +1,192 @@
+#include "BlockStore.hpp"
+#include "BlockCodec.hpp"
+
+#include <cstring>
+
+namespace {
+constexpr std::size_t kPayload = DoubleListPool::kPayload;
+}
+
+BlockWriter::BlockWriter(std::size_t packetsPerBlock, std::size_t maxBlocks)
+    : perBlock_(packetsPerBlock ? packetsPerBlock : 1), maxBlocks_(maxBlocks < 2 ? 2 : maxBlocks) {}
+
+BlockWriter::~BlockWriter() {
+    close();
+    delete cur_;
+    for (Block* b : spare_) delete b;
+}
+
+bool BlockWriter::open(const std::string& path) {
+    data_ = std::fopen(path.c_str(), "ab");
+    idx_  = std::fopen((path + ".idx").c_str(), "ab+");
+    if (!data_ || !idx_) {
+        std::perror("[blocks] fopen");
+        if (data_) { std::fclose(data_); data_ = nullptr; }
+        if (idx_)  { std::fclose(idx_); idx_ = nullptr; }
+        return false;
+    }
+
+    // Resume numbering after the last indexed block of a previous run.
+    _fseeki64(data_, 0, SEEK_END);
+    dataOff_ = (std::uint64_t)_ftelli64(data_);
+    _fseeki64(idx_, 0, SEEK_END);
+    long long idxBytes = _ftelli64(idx_);
+    if (idxBytes >= (long long)sizeof(BlockIndexEntry)) {
+        BlockIndexEntry last{};
+        _fseeki64(idx_, idxBytes - idxBytes % (long long)sizeof last - (long long)sizeof last, SEEK_SET);
+        if (std::fread(&last, sizeof last, 1, idx_) == 1)
+            nextPacket_ = last.firstPacket + last.rawBytes / kPayload;
+        _fseeki64(idx_, 0, SEEK_END);
+    }
+
+    out_.resize(blockcodec::bound(perBlock_ * kPayload));
+    cur_ = takeSpare();
+    closing_ = false;
+    helper_ = std::thread(&BlockWriter::helperMain, this);
+    return true;
+}
+
+BlockWriter::Block* BlockWriter::takeSpare() {
+    Block* b = nullptr;
+    {
+        std::unique_lock<std::mutex> lk(mx_);
+        // Helper behind and every buffer in use: wait for it instead of growing.
+        if (spare_.empty() && allocated_ >= maxBlocks_)
+            cvSpare_.wait(lk, [&] { return !spare_.empty() || failed_.load(); });
+        if (!spare_.empty()) { b = spare_.back(); spare_.pop_back(); }
+    }
+    if (!b) {
+        if (failed_.load()) return nullptr;
+        b = new Block();
+        b->data.reset(new std::uint8_t[perBlock_ * kPayload]);
+        ++allocated_;
+    }
+    b->packets = 0;
+    b->first   = nextPacket_;
+    return b;
+}
+
+void BlockWriter::submit(Block* b) {
+    std::lock_guard<std::mutex> lk(mx_);
+    full_.push_back(b);
+    cv_.notify_one();
+}
+
+bool BlockWriter::append(const std::uint8_t* packet) {
+    if (!cur_ || failed_.load()) return false;
+    std::memcpy(cur_->data.get() + cur_->packets * kPayload, packet, kPayload);
+    ++nextPacket_;
+    if (++cur_->packets == perBlock_) {
+        submit(cur_);
+        cur_ = takeSpare();
+    }
+    return true;
+}
+
+void BlockWriter::close() {
+    if (!helper_.joinable()) return;
+    if (cur_ && cur_->packets) {
+        submit(cur_);
+        cur_ = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mx_);
+        closing_ = true;
+        cv_.notify_one();
+    }
+    helper_.join();
+    if (data_) { std::fclose(data_); data_ = nullptr; }
+    if (idx_)  { std::fclose(idx_); idx_ = nullptr; }
+}
+
+void BlockWriter::helperMain() {
+    for (;;) {
+        Block* b = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(mx_);
+            cv_.wait(lk, [&] { return closing_ || !full_.empty(); });
+            if (full_.empty()) return; // closing and drained
+            b = full_.front();
+            full_.pop_front();
+        }
+        // After a failed write the files end at the last good block: later
+        // blocks are dropped rather than written past a hole.
+        if (!failed_.load() && !writeBlock(*b)) {
+            std::perror("[blocks] write");
+            failed_.store(true);
+        }
+        std::lock_guard<std::mutex> lk(mx_);
+        spare_.push_back(b);
+        cvSpare_.notify_one();
+    }
+}
+
+bool BlockWriter::writeBlock(const Block& b) {
+    const std::size_t raw = b.packets * kPayload;
+    std::size_t stored = blockcodec::compress(b.data.get(), raw, out_.data());
+
+    BlockHeader h{};
+    h.magic       = kBlockMagic;
+    h.rawBytes    = (std::uint32_t)raw;
+    h.firstPacket = b.first;
+    const std::uint8_t* payload = out_.data();
+    if (stored >= raw) { // incompressible: keep it raw
+        stored  = raw;
+        payload = b.data.get();
+        h.flags = BlockHeader::kStoredRaw;
+    }
+    h.storedBytes = (std::uint32_t)stored;
+
+    BlockIndexEntry e{b.first, dataOff_, h.storedBytes, h.rawBytes};
+    if (std::fwrite(&h, sizeof h, 1, data_) != 1) return false;
+    if (std::fwrite(payload, 1, stored, data_) != stored) return false;
+    // Data before index: a reader never finds an entry for a block not yet on disk.
+    std::fflush(data_);
+    if (std::fwrite(&e, sizeof e, 1, idx_) != 1) return false;
+    std::fflush(idx_);
+
+    dataOff_ += sizeof h + stored;
+    blocks_++;
+    raw_ += raw;
+    stored_ += sizeof h + stored;
+    return true;
+}
+
+bool readBlockPacket(const std::string& path, std::uint64_t index, std::uint8_t* out) {
+    std::FILE* fi = std::fopen((path + ".idx").c_str(), "rb");
+    if (!fi) return false;
+    _fseeki64(fi, 0, SEEK_END);
+    long long count = _ftelli64(fi) / (long long)sizeof(BlockIndexEntry);
+
+    // Binary search for the last block with firstPacket <= index.
+    BlockIndexEntry e{};
+    bool found = false;
+    long long lo = 0, hi = count - 1;
+    while (lo <= hi) {
+        long long mid = lo + (hi - lo) / 2;
+        BlockIndexEntry m{};
+        _fseeki64(fi, mid * (long long)sizeof m, SEEK_SET);
+        if (std::fread(&m, sizeof m, 1, fi) != 1) break;
+        if (m.firstPacket <= index) { e = m; found = true; lo = mid + 1; }
+        else hi = mid - 1;
+    }
+    std::fclose(fi);
+    if (!found || index >= e.firstPacket + e.rawBytes / kPayload) return false;
+
+    std::FILE* fd = std::fopen(path.c_str(), "rb");
+    if (!fd) return false;
+    BlockHeader h{};
+    std::vector<std::uint8_t> stored(e.storedBytes), raw(e.rawBytes);
+    bool ok = _fseeki64(fd, (long long)e.offset, SEEK_SET) == 0 &&
+              std::fread(&h, sizeof h, 1, fd) == 1 && h.magic == kBlockMagic &&
+              h.storedBytes == e.storedBytes &&
+              std::fread(stored.data(), 1, stored.size(), fd) == stored.size();
+    std::fclose(fd);
+    if (!ok) return false;
+
+    if (h.flags & BlockHeader::kStoredRaw) raw = std::move(stored);
+    else if (!blockcodec::decompress(stored.data(), stored.size(), raw.data(), raw.size())) return false;
+
+    std::memcpy(out, raw.data() + (index - e.firstPacket) * kPayload, kPayload);
+    return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DoubleListPool.hpp" // kPayload
+
+// Seekable block-compressed capture:
+//   <path>      BlockHeader + payload, one per block (payload compressed unless kStoredRaw)
+//   <path>.idx  one BlockIndexEntry per block, in packet order
+// To read packet N: binary-search the index for the block holding N, read and
+// decompress that single block.
+constexpr std::uint32_t kBlockMagic = 0x314B5042; // "BPK1"
+
+struct BlockHeader {
+    std::uint32_t magic;
+    std::uint32_t rawBytes;     // packets * kPayload
+    std::uint32_t storedBytes;  // bytes following this header
+    std::uint32_t flags;        // kStoredRaw: codec didn't help, payload is raw
+    std::uint64_t firstPacket;
+    static constexpr std::uint32_t kStoredRaw = 1;
+};
+
+struct BlockIndexEntry {
+    std::uint64_t firstPacket;
+    std::uint64_t offset;       // of the BlockHeader in the data file
+    std::uint32_t storedBytes;
+    std::uint32_t rawBytes;
+};
+
+// Collects packets into blocks on the writer thread and compresses/writes them
+// on a helper thread. Full blocks are queued and a fresh buffer is taken from
+// the spare list. At most maxBlocks buffers exist: when the helper is that far
+// behind, append() waits for one (the pool absorbs the burst meanwhile).
+class BlockWriter {
+public:
+    explicit BlockWriter(std::size_t packetsPerBlock, std::size_t maxBlocks = 8);
+    ~BlockWriter();
+
+    // Opens (appends to) path and path.idx, continues packet numbering from
+    // the existing index, and starts the helper thread.
+    bool open(const std::string& path);
+
+    // Writer thread only: copy one kPayload-byte packet into the current block.
+    // false once a block write failed; nothing after it reaches the files.
+    bool append(const std::uint8_t* packet);
+
+    // Queue the partial block, let the helper drain, join, close files. Idempotent.
+    void close();
+
+    std::uint64_t blocks()      const { return blocks_.load(); }
+    std::uint64_t rawBytes()    const { return raw_.load(); }
+    std::uint64_t storedBytes() const { return stored_.load(); }
+    bool          failed()      const { return failed_.load(); }
+
+private:
+    struct Block {
+        std::unique_ptr<std::uint8_t[]> data;
+        std::size_t   packets = 0;
+        std::uint64_t first   = 0;
+    };
+
+    Block* takeSpare();
+    void   submit(Block* b);
+    void   helperMain();
+    bool   writeBlock(const Block& b);
+
+    const std::size_t perBlock_;
+    const std::size_t maxBlocks_;
+    std::size_t       allocated_{0};    // writer thread only
+    Block*            cur_{nullptr};
+    std::uint64_t     nextPacket_{0};
+
+    std::mutex              mx_;
+    std::condition_variable cv_;
+    std::condition_variable cvSpare_;
+    std::deque<Block*>      full_;
+    std::vector<Block*>     spare_;
+    bool                    closing_{false};
+    std::thread             helper_;
+
+    // helper thread only
+    std::FILE*                data_{nullptr};
+    std::FILE*                idx_{nullptr};
+    std::uint64_t             dataOff_{0};
+    std::vector<std::uint8_t> out_;
+
+    std::atomic<std::uint64_t> blocks_{0}, raw_{0}, stored_{0};
+    std::atomic<bool>          failed_{false};
+};
+
+// Random access: decompress packet 'index' of a block-compressed capture into
+// out[kPayload]. Returns false if the index is out of range or data is corrupt.
+bool readBlockPacket(const std::string& path, std::uint64_t index, std::uint8_t* out);
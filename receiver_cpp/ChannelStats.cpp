@@ -0,0 +1,162 @@
+#include "ChannelStats.hpp"
+#include <cstring>
+#include <emmintrin.h>
+
+namespace {
+
+constexpr std::size_t kVec = 96;   // bytes handled 16 at a time; the last 4 are scalar
+
+void minMaxInto(std::uint8_t* mn, std::uint8_t* mx, const std::uint8_t* bmn, const std::uint8_t* bmx) {
+    for (std::size_t i = 0; i < kVec; i += 16) {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(mn + i));
+        __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(mx + i));
+        _mm_store_si128(reinterpret_cast<__m128i*>(mn + i),
+                        _mm_min_epu8(a, _mm_load_si128(reinterpret_cast<const __m128i*>(bmn + i))));
+        _mm_store_si128(reinterpret_cast<__m128i*>(mx + i),
+                        _mm_max_epu8(b, _mm_load_si128(reinterpret_cast<const __m128i*>(bmx + i))));
+    }
+    for (std::size_t i = kVec; i < ChannelStats::kBytes; ++i) {
+        if (bmn[i] < mn[i]) mn[i] = bmn[i];
+        if (bmx[i] > mx[i]) mx[i] = bmx[i];
+    }
+}
+
+} // namespace
+
+void ChannelStats::Bucket::reset(std::int64_t s) {
+    stamp = s;
+    packets = violations = 0;
+    std::memset(min, 0xFF, sizeof min);
+    std::memset(max, 0, sizeof max);
+    std::memset(sum, 0, sizeof sum);
+}
+
+void ChannelStats::Bucket::merge(const Bucket& b) {
+    if (!b.packets) return;
+    packets += b.packets;
+    violations += b.violations;
+    minMaxInto(min, max, b.min, b.max);
+    for (std::size_t i = 0; i < kBytes; ++i) sum[i] += b.sum[i];
+}
+
+ChannelStats::ChannelStats(const Config& cfg) : cfg_(cfg), ch_(cfg.channels ? cfg.channels : 1) {
+    if (cfg_.frameLen < 1 || cfg_.frameLen > kBytes) cfg_.frameLen = kBytes;
+    for (Channel& c : ch_) {
+        c.cur.reset(-1);
+        c.minute.reset(-1);
+        for (Bucket& b : c.secs) b.reset(-1);
+        for (Bucket& b : c.mins) b.reset(-1);
+        std::memset(c.part, 0, sizeof c.part);
+    }
+}
+
+ChannelStats::~ChannelStats() = default;
+
+void ChannelStats::foldPartial(Channel& c) {
+    for (std::size_t i = 0; i < kVec; ++i) c.cur.sum[i] += c.part[i];
+    std::memset(c.part, 0, sizeof c.part);
+    c.partCount = 0;
+}
+
+void ChannelStats::accumulate(Channel& c, const std::uint8_t* p) {
+    const __m128i zero = _mm_setzero_si128();
+    for (std::size_t i = 0; i < kVec; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i* mn = reinterpret_cast<__m128i*>(c.cur.min + i);
+        __m128i* mx = reinterpret_cast<__m128i*>(c.cur.max + i);
+        _mm_store_si128(mn, _mm_min_epu8(_mm_load_si128(mn), v));
+        _mm_store_si128(mx, _mm_max_epu8(_mm_load_si128(mx), v));
+        __m128i* lo = reinterpret_cast<__m128i*>(c.part + i);
+        __m128i* hi = reinterpret_cast<__m128i*>(c.part + i + 8);
+        _mm_store_si128(lo, _mm_add_epi16(_mm_load_si128(lo), _mm_unpacklo_epi8(v, zero)));
+        _mm_store_si128(hi, _mm_add_epi16(_mm_load_si128(hi), _mm_unpackhi_epi8(v, zero)));
+    }
+    for (std::size_t i = kVec; i < kBytes; ++i) {
+        if (p[i] < c.cur.min[i]) c.cur.min[i] = p[i];
+        if (p[i] > c.cur.max[i]) c.cur.max[i] = p[i];
+        c.cur.sum[i] += p[i];
+    }
+    // 257 * 255 is the most a 16-bit lane can hold
+    if (++c.partCount == 257) foldPartial(c);
+}
+
+void ChannelStats::update(const std::uint8_t* p, std::int64_t nowSec) {
+    if (nowSec != curSec_) roll(nowSec);
+    Channel& c = ch_[cfg_.channelOffset < 0 ? 0 : p[cfg_.channelOffset] % ch_.size()];
+    if (c.cur.stamp != nowSec) c.cur.reset(nowSec);
+    ++c.cur.packets;
+    if (cfg_.checkPattern && (p[0] != cfg_.start || p[cfg_.frameLen - 1] != cfg_.end))
+        ++c.cur.violations;
+    accumulate(c, p);
+}
+
+// Close the finished second on every channel (idle channels too, so their
+// windows age out) and publish new snapshots.
+void ChannelStats::roll(std::int64_t nowSec) {
+    if (firstSec_ < 0) firstSec_ = nowSec;
+    const std::int64_t done = curSec_;
+    curSec_ = nowSec;
+    if (done < 0) return;
+
+    for (Channel& c : ch_) {
+        foldPartial(c);
+        Bucket& slot = c.secs[done % 60];
+        if (c.cur.stamp == done) slot = c.cur;
+        else                     slot.reset(done);
+        c.cur.reset(nowSec);
+
+        const std::int64_t minute = done / 60;
+        if (c.minute.stamp != minute) {
+            if (c.minute.stamp >= 0) c.mins[c.minute.stamp % 60] = c.minute;
+            c.minute.reset(minute);
+        }
+        c.minute.merge(slot);
+        publish(c, done);
+    }
+}
+
+void ChannelStats::publish(Channel& c, std::int64_t sec) {
+    Bucket acc[kWindows];
+    for (Bucket& b : acc) b.reset(sec);
+    acc[Second].merge(c.secs[sec % 60]);
+    for (const Bucket& b : c.secs)
+        if (b.stamp > sec - 60 && b.stamp <= sec) acc[Minute].merge(b);
+    acc[Hour].merge(c.minute);
+    const std::int64_t minute = sec / 60;
+    for (const Bucket& b : c.mins)
+        if (b.stamp > minute - 60 && b.stamp < minute) acc[Hour].merge(b);
+
+    // Until the receiver has run a full window, rates are over the time it has run.
+    const double ran = (double)(sec - firstSec_ + 1);
+    const double span[kWindows] = {1.0, ran < 60 ? ran : 60.0, ran < 3600 ? ran : 3600.0};
+
+    const std::uint32_t s = c.seq.load(std::memory_order_relaxed);
+    c.seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    c.snap.asOf = sec;
+    for (int w = 0; w < kWindows; ++w) {
+        WindowStats& o = c.snap.w[w];
+        const Bucket& b = acc[w];
+        o.packets = b.packets;
+        o.violations = b.violations;
+        o.rate = (double)b.packets / span[w];
+        for (std::size_t i = 0; i < kBytes; ++i) {
+            o.min[i]  = b.packets ? b.min[i] : 0;
+            o.max[i]  = b.max[i];
+            o.mean[i] = b.packets ? (float)((double)b.sum[i] / (double)b.packets) : 0.0f;
+        }
+    }
+    c.seq.store(s + 2, std::memory_order_release);
+}
+
+bool ChannelStats::snapshot(std::size_t channel, Snapshot& out) const {
+    if (channel >= ch_.size()) return false;
+    const Channel& c = ch_[channel];
+    for (;;) {
+        const std::uint32_t s1 = c.seq.load(std::memory_order_acquire);
+        if (s1 & 1) { YieldProcessor(); continue; }   // publish in progress
+        out = c.snap;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (c.seq.load(std::memory_order_relaxed) == s1) return out.asOf >= 0;
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DoubleListPool.hpp"
+
+// Rolling per-channel statistics over the last second, minute and hour,
+// updated packet by packet on the writer thread (no re-reading packets.bin).
+//
+// The writer folds each payload into the current second with SSE2 min/max/sum
+// kernels. When the second changes, the buckets roll and a snapshot per
+// channel is published under a seqlock: readers copy it from any thread
+// without taking a lock or slowing the writer down.
+class ChannelStats {
+public:
+    static constexpr std::size_t kBytes = DoubleListPool::kPayload;
+
+    enum Window { Second = 0, Minute, Hour, kWindows };
+
+    struct Config {
+        int          channelOffset = -1;    // payload byte holding the channel id; -1 = one channel
+        std::size_t  channels      = 1;     // ids are taken modulo this
+        bool         checkPattern  = false; // count packets not framed as start..end
+        std::uint8_t start         = '$';
+        std::uint8_t end           = '#';
+        std::size_t  frameLen      = kBytes;
+    };
+
+    struct WindowStats {
+        std::uint64_t packets    = 0;
+        std::uint64_t violations = 0;
+        double        rate       = 0.0;     // packets/s over the covered part of the window
+        std::array<std::uint8_t, kBytes> min{};
+        std::array<std::uint8_t, kBytes> max{};
+        std::array<float, kBytes>        mean{};
+    };
+
+    struct Snapshot {
+        std::int64_t asOf = -1;             // last completed second (GetTickCount64 / 1000)
+        WindowStats  w[kWindows];
+    };
+
+    explicit ChannelStats(const Config& cfg);
+    ~ChannelStats();
+
+    ChannelStats(const ChannelStats&) = delete;
+    ChannelStats& operator=(const ChannelStats&) = delete;
+
+    // Writer thread only: account one payload received in second 'nowSec'.
+    void update(const std::uint8_t* payload, std::int64_t nowSec);
+
+    // Any thread: copy the latest published snapshot. false until the first
+    // second has completed (or if 'channel' is out of range).
+    bool snapshot(std::size_t channel, Snapshot& out) const;
+
+    std::size_t channels() const { return ch_.size(); }
+
+    static std::int64_t nowSeconds() { return (std::int64_t)(GetTickCount64() / 1000); }
+
+private:
+    struct Bucket {                         // one second or one minute
+        std::int64_t  stamp = -1;           // second or minute number; -1 = empty
+        std::uint64_t packets = 0;
+        std::uint64_t violations = 0;
+        alignas(16) std::uint8_t min[kBytes];
+        alignas(16) std::uint8_t max[kBytes];
+        std::uint64_t sum[kBytes];
+        void reset(std::int64_t s);
+        void merge(const Bucket& b);
+    };
+
+    struct Channel {
+        // current second: byte sums go to 16-bit lanes first (SIMD-friendly),
+        // folded into cur.sum before they can overflow
+        Bucket        cur;
+        alignas(16) std::uint16_t part[96];
+        std::uint32_t partCount = 0;
+        Bucket        minute;               // current minute, completed seconds only
+        Bucket        secs[60];
+        Bucket        mins[60];
+
+        std::atomic<std::uint32_t> seq{0};
+        Snapshot      snap;
+    };
+
+    void accumulate(Channel& c, const std::uint8_t* p);
+    void foldPartial(Channel& c);
+    void roll(std::int64_t nowSec);
+    void publish(Channel& c, std::int64_t sec);
+
+    Config                   cfg_;
+    std::vector<Channel>     ch_;
+    std::int64_t             curSec_{-1};
+    std::int64_t             firstSec_{-1};
+};
@@ -1,12 +1,72 @@
 #pragma once
 #include <cstddef> 
+#include "WaitStrategy.hpp"
 // Networking
 constexpr unsigned short LISTENER_PORT = 5555;
 
+// Framing: false = blind 100-byte chunks, true = start/end delimited frames
+// (e.g. the README's Arduino sketch: '$' + 98 bytes + '#')
+constexpr bool LISTENER_DELIMITED = false;
+constexpr unsigned char FRAME_START_BYTE = '$';
+constexpr unsigned char FRAME_END_BYTE = '#';
+constexpr std::size_t FRAME_LEN = 100;              // incl. delimiters, <= 100 (shorter frames are zero-padded)
+constexpr std::size_t LISTENER_RECV_BUFFER = 64 * 1024;
+// Ingest engine: false = recv() loop, true = Registered I/O (overridable with --engine classic|rio)
+constexpr bool LISTENER_RIO = false;
+constexpr std::size_t LISTENER_RIO_DEPTH = 64;      // receives in flight (one pool node each)
+// Transport: false = one TCP client, true = UDP datagrams from any number of sources (--udp)
+constexpr bool LISTENER_UDP = false;
+constexpr std::size_t LISTENER_UDP_RCVBUF_KB = 8192;
+// Striped TCP (--striped): one sender over several connections, reordered by seq
+constexpr bool LISTENER_STRIPED = false;
+constexpr std::size_t STRIPE_REORDER_WINDOW = 16384;   // frames held while waiting for a gap
+// Session resume (--resume): acknowledge frames and take the sender back after
+// a dropped connection, keeping the pool and writer
+constexpr bool LISTENER_RESUME = false;
+
 // Pool
 constexpr std::size_t POOL_PREALLOC_NODES = 1024;
+constexpr WaitStrategy POOL_WAIT_STRATEGY = WaitStrategy::Block; // Block / Spin / SpinThenPark
+constexpr std::uint32_t POOL_SPIN_LIMIT = 20000;                 // pauses before parking (SpinThenPark)
 
 // Writer
 constexpr std::size_t WRITER_FLUSH_EVERY = 100;
 constexpr std::size_t WRITER_STDIO_BUFFER_KB = 1024;
 constexpr const char* WRITER_OUTPUT_FILE = "packets.bin";
+// Block-compressed output: packets.bpk + packets.bpk.idx, seekable by packet number
+constexpr bool WRITER_COMPRESSED = false;
+constexpr const char* WRITER_COMPRESSED_FILE = "packets.bpk";
+constexpr std::size_t WRITER_BLOCK_PACKETS = 655;   // ~64 KB of payload per block
+constexpr std::size_t WRITER_BLOCK_BUFFERS = 8;     // blocks queued for the compressor before the writer waits
+// Writer pipeline: drop packets not framed as FRAME_START_BYTE ... FRAME_END_BYTE
+// over FRAME_LEN bytes instead of writing them (single writer thread only)
+constexpr bool WRITER_DROP_MALFORMED = false;
+// Parallel raw writer (overridable with --writers N): N threads write runs of
+// consecutive packets at their own offsets; 1 = the single fwrite thread
+constexpr unsigned WRITER_THREADS = 1;
+constexpr std::size_t WRITER_RUN_PACKETS = 655;     // ~64 KB per positional write
+constexpr unsigned WRITER_COMMIT_MS = 50;   // flush + publish the committed length at least this often when idle
+
+// Query / tail server on the raw output file (overridable with --query PATH|tcp:PORT|off)
+constexpr bool QUERY_ENABLED = true;
+constexpr const char* QUERY_SOCKET_PATH = "receiver.sock";   // AF_UNIX path; shard i uses receiver.shard<i>.sock
+
+// Rolling per-channel stats over 1 s / 1 min / 1 h, updated by the writer
+constexpr bool STATS_ENABLED = true;
+constexpr int STATS_CHANNEL_OFFSET = -1;      // payload byte holding the channel id, -1 = single channel
+constexpr std::size_t STATS_CHANNELS = 16;    // channel ids are taken modulo this
+constexpr bool STATS_CHECK_PATTERN = false;   // count packets without FRAME_START_BYTE / FRAME_END_BYTE
+constexpr unsigned STATS_PRINT_SECONDS = 10;  // console summary period, 0 = off
+constexpr bool STATS_ON_THREAD = false;       // update on a helper thread (SPSC ring) instead of the writer
+
+// Sharding (overridable with --shards N): shard i listens on LISTENER_PORT + i
+// and owns its own pool, listener, writer and output file (packets.shard<i>.bin)
+constexpr unsigned RECEIVER_SHARDS = 1;
+constexpr bool SHARD_PIN_CORES = true;   // shard i's threads on CPU i (N > 1 only)
+
+// Thread placement (cpu mask 0 = any CPU; priority = THREAD_PRIORITY_*, 15 = time critical)
+// The pool slab is allocated on the NUMA node of the listener's CPUs.
+constexpr unsigned long long LISTENER_CPU_MASK = 0;
+constexpr int LISTENER_PRIORITY = 0;
+constexpr unsigned long long WRITER_CPU_MASK = 0;
+constexpr int WRITER_PRIORITY = 0;
@@ -1,10 +1,19 @@
 #pragma once
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <mutex>
 #include <condition_variable>
+#include <new>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+#include "WaitStrategy.hpp"
 
 class DoubleListPool {
 public:
@@ -16,29 +25,52 @@ public:
     };
 
     // capacity_hint: how many nodes to preallocate (e.g., 1024)
-    explicit DoubleListPool(std::size_t capacity_hint = 0);
+    // numa_node: node the preallocated slab should live on (-1 = let the OS pick)
+    explicit DoubleListPool(std::size_t capacity_hint = 0, int numa_node = -1);
 
     ~DoubleListPool();
+
+    // How getNode() waits on an empty ready list (call before the threads start).
+    // spin_limit only matters for SpinThenPark.
+    void setWaitStrategy(WaitStrategy s, std::uint32_t spin_limit = 20000) {
+        strategy_ = s;
+        spin_limit_ = spin_limit;
+    }
+    WaitStrategy waitStrategy() const { return strategy_; }
+
     // ----- producer-side API -----
 
-    // Get an empty node to fill. Allocates a new one if the free list is empty.
+    // Get an empty node to fill. Allocates a new one if the free list is empty
+    // (outside the lock, so the writer is never stuck behind the heap).
     Node* getFree() {
+        {
+            std::lock_guard<std::mutex> lk(mx_);
+            if (closed_) return nullptr;
+            Node* n = try_pop_free_unsafe();
+            if (n) { --free_count_; return n; }
+        }
+        grown_.fetch_add(1, std::memory_order_relaxed);
+        return new Node(); // expand pool on demand
+    }
+
+    // Like getFree() but never grows: returns a free slab node, or nullptr if
+    // none is free right now (heap nodes on the free list are left alone).
+    Node* tryGetSlabNode() {
         std::lock_guard<std::mutex> lk(mx_);
-        if (closed_) return nullptr;
+        if (closed_ || !free_head_ || !in_slab(free_head_)) return nullptr;
         Node* n = try_pop_free_unsafe();
-        if (!n) {
-            n = new Node(); // expand pool on demand
-        } else {
-            --free_count_;
-        }
+        --free_count_;
         return n;
     }
 
+    // Nodes allocated beyond the preallocated ones (growth = the writer fell behind).
+    std::size_t grown() const { return grown_.load(std::memory_order_relaxed); }
+
     // After filling node->data, push to the tail of the ready list and wake a consumer.
     bool addNode(Node* n) {
         if (!n) return false;
         std::lock_guard<std::mutex> lk(mx_);
-        if (closed_) { delete n; return false; }
+        if (closed_) return false; // caller still owns n (may be a slab node)
         n->next = nullptr;
         if (!ready_tail_) {
             ready_head_ = ready_tail_ = n;
@@ -47,24 +79,97 @@ public:
             ready_tail_ = n;
         }
         ++ready_count_;
-        cv_not_empty_.notify_one();
+        // Only pay for a futex/keyed-event wake when the consumer is really asleep.
+        if (sleepers_) {
+            wake_stamp_ = std::chrono::steady_clock::now();
+            ++stats_.wakeups;
+            cv_not_empty_.notify_one();
+        } else {
+            ++stats_.wakeupsSkipped;
+        }
         return true;
     }
 
     // ----- consumer-side API -----
 
     // Blocking: pop one ready node; returns nullptr if closed and empty.
+    // Spins first unless the strategy is Block (see setWaitStrategy).
     Node* getNode() {
+        if (strategy_ != WaitStrategy::Block) spin_for_ready();
         std::unique_lock<std::mutex> lk(mx_);
-        cv_not_empty_.wait(lk, [&]{ return closed_ || (ready_head_ != nullptr); });
+        if (!closed_ && !ready_head_) {
+            ++sleepers_;
+            ++stats_.parks;
+            cv_not_empty_.wait(lk, [&]{ return closed_ || (ready_head_ != nullptr); });
+            --sleepers_;
+            if (ready_head_) record_wake_unsafe();
+        }
         if (!ready_head_) return nullptr; // closed & drained
-        Node* n = try_pop_ready_unsafe();
-        --ready_count_;
-        // If we just made room, wake potential producer waiting for "space" (not used here, but ok)
+        return take_ready_unsafe();
+    }
+
+    // Like getNode(), but gives up after timeoutMs (even under Spin): returns
+    // nullptr with timedOut set, so the consumer can do idle work and call again.
+    Node* getNode(unsigned timeoutMs, bool& timedOut) {
+        timedOut = false;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        if (strategy_ != WaitStrategy::Block) spin_for_ready(&deadline);
+        std::unique_lock<std::mutex> lk(mx_);
+        if (!closed_ && !ready_head_ && std::chrono::steady_clock::now() < deadline) {
+            ++sleepers_;
+            ++stats_.parks;
+            cv_not_empty_.wait_until(lk, deadline, [&]{ return closed_ || (ready_head_ != nullptr); });
+            --sleepers_;
+            if (ready_head_) record_wake_unsafe();
+        }
+        if (!ready_head_) { timedOut = !closed_; return nullptr; }
+        return take_ready_unsafe();
+    }
+
+    // Blocking: pop up to 'max' consecutive ready nodes as a chain (linked by
+    // next, oldest first). first_seq receives the arrival index of the first
+    // one; indices count every node handed out by getRun(). run_index numbers
+    // the runs themselves (0, 1, 2 ...). Returns 0 if closed and empty. For
+    // several consumers that write by position.
+    std::size_t getRun(Node*& head, std::size_t max, std::uint64_t& first_seq, std::uint64_t& run_index) {
+        if (strategy_ != WaitStrategy::Block) spin_for_ready();
+        std::unique_lock<std::mutex> lk(mx_);
+        if (!closed_ && !ready_head_) {
+            ++sleepers_;
+            ++stats_.parks;
+            cv_not_empty_.wait(lk, [&]{ return closed_ || (ready_head_ != nullptr); });
+            --sleepers_;
+            if (ready_head_) record_wake_unsafe();
+        }
+        head = ready_head_;
+        std::size_t n = 0;
+        Node* last = nullptr;
+        while (ready_head_ && n < max) {
+            last = ready_head_;
+            ready_head_ = ready_head_->next;
+            ++n;
+        }
+        if (!n) return 0; // closed & drained
+        last->next = nullptr;
+        if (!ready_head_) ready_tail_ = nullptr;
+        ready_count_ -= n;
+        first_seq = run_seq_;
+        run_seq_ += n;
+        run_index = run_count_++;
         cv_not_full_.notify_one();
         return n;
     }
 
+    // Return a whole chain (head..tail, n nodes) to the free list under one lock.
+    void addFreeRun(Node* head, Node* tail, std::size_t n) {
+        if (!head) return;
+        std::lock_guard<std::mutex> lk(mx_);
+        tail->next = free_head_;
+        free_head_ = head;
+        free_count_ += n;
+        cv_not_full_.notify_one();
+    }
+
     // After processing/printing, return the node to the free list.
     void addFree(Node* n) {
         if (!n) return;
@@ -77,8 +182,7 @@ public:
 
     // Non-blocking peek sizes (approximate)
     std::size_t readySize() const {
-        std::lock_guard<std::mutex> lk(mx_);
-        return ready_count_;
+        return ready_count_.load(std::memory_order_relaxed);
     }
     std::size_t freeSize() const {
         std::lock_guard<std::mutex> lk(mx_);
@@ -93,6 +197,23 @@ public:
         cv_not_full_.notify_all();
     }
 
+    // Call after the consumers have stopped.
+    WaitStats waitStats() const {
+        std::lock_guard<std::mutex> lk(mx_);
+        WaitStats s = stats_;
+        s.spins = spins_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // NUMA node the slab was actually placed on (-1 = unknown / not requested)
+    int numaNode() const { return numa_node_; }
+
+    // The preallocated slab as one contiguous range (e.g. to register it for
+    // Registered I/O). Nodes grown on demand live outside it.
+    void*       slabBase()  const { return slab_; }
+    std::size_t slabBytes() const { return slab_count_ * sizeof(Node); }
+    bool        inSlab(const Node* n) const { return in_slab(n); }
+
 private:
     // Unsafe helpers (caller holds mx_)
     Node* try_pop_free_unsafe() {
@@ -100,6 +221,37 @@ private:
         if (n) free_head_ = n->next;
         return n;
     }
+    // Poll the ready count without the lock. Spin never gives up (unless a
+    // deadline is given, checked every 1024 pauses); SpinThenPark falls through
+    // to the condition variable after spin_limit_ pauses.
+    void spin_for_ready(const std::chrono::steady_clock::time_point* deadline = nullptr) {
+        std::uint64_t spins = 0;
+        const std::uint64_t limit = strategy_ == WaitStrategy::Spin ? UINT64_MAX : spin_limit_;
+        while (ready_count_.load(std::memory_order_acquire) == 0 &&
+               !closed_.load(std::memory_order_acquire) && spins < limit) {
+            YieldProcessor();
+            ++spins;
+            if (deadline && (spins & 1023) == 0 && std::chrono::steady_clock::now() >= *deadline) break;
+        }
+        if (spins) spins_.fetch_add(spins, std::memory_order_relaxed);
+    }
+    void record_wake_unsafe() {
+        auto ns = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - wake_stamp_).count();
+        ++stats_.wakeSamples;
+        stats_.wakeTotalNs += ns;
+        if (ns > stats_.wakeMaxNs) stats_.wakeMaxNs = ns;
+    }
+    bool in_slab(const Node* n) const {
+        return slab_ && n >= slab_ && n < slab_ + slab_count_;
+    }
+    Node* take_ready_unsafe() {
+        Node* n = try_pop_ready_unsafe();
+        --ready_count_;
+        // If we just made room, wake potential producer waiting for "space" (not used here, but ok)
+        cv_not_full_.notify_one();
+        return n;
+    }
     Node* try_pop_ready_unsafe() {
         Node* n = ready_head_;
         if (!n) return nullptr;
@@ -115,11 +267,70 @@ private:
     std::size_t free_count_;
     Node* ready_head_;
     Node* ready_tail_;
-    std::size_t ready_count_;
+    std::atomic<std::size_t> ready_count_; // atomic so spinners can poll it lock-free
+    std::uint64_t run_seq_ = 0;            // next getRun() index (guarded by mx_)
+    std::uint64_t run_count_ = 0;          // runs handed out so far (guarded by mx_)
 
     // sync
     mutable std::mutex mx_;
     std::condition_variable cv_not_empty_;
     std::condition_variable cv_not_full_; // present for symmetry/future capacity logic
-    bool closed_;
+    std::atomic<bool> closed_;
+    std::atomic<std::size_t> grown_{0};
+
+    // waiting policy + accounting (sleepers_/stats_/wake_stamp_ guarded by mx_)
+    WaitStrategy strategy_ = WaitStrategy::Block;
+    std::uint32_t spin_limit_ = 20000;
+    std::size_t sleepers_ = 0;
+    WaitStats stats_{};
+    std::chrono::steady_clock::time_point wake_stamp_{};
+    std::atomic<std::uint64_t> spins_{0}; // consumer side (several with getRun)
+
+    // preallocated nodes (one VirtualAlloc'd block, NUMA-local when requested)
+    Node* slab_ = nullptr;
+    std::size_t slab_count_ = 0;
+    int numa_node_ = -1;
 };
+
+inline DoubleListPool::DoubleListPool(std::size_t capacity_hint, int numa_node)
+    : free_head_(nullptr), free_count_(0),
+      ready_head_(nullptr), ready_tail_(nullptr), ready_count_(0),
+      closed_(false) {
+    if (!capacity_hint) return;
+
+    // One slab instead of N small allocations; VirtualAllocExNuma commits the
+    // pages on the requested node so the first touch does not decide placement.
+    const SIZE_T bytes = capacity_hint * sizeof(Node);
+    void* mem = nullptr;
+    if (numa_node >= 0) {
+        mem = VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes,
+                                 MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, (DWORD)numa_node);
+        if (mem) numa_node_ = numa_node;
+    }
+    if (!mem) mem = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!mem) return; // fall back to growing on demand
+
+    slab_ = static_cast<Node*>(mem);
+    slab_count_ = capacity_hint;
+    for (std::size_t i = slab_count_; i-- > 0;) {
+        Node* n = new (&slab_[i]) Node();
+        n->next = free_head_;
+        free_head_ = n;
+    }
+    free_count_ = slab_count_;
+}
+
+inline DoubleListPool::~DoubleListPool() {
+    // Nodes still held by a thread at this point are leaked on purpose;
+    // the listener/writer return everything before they exit.
+    auto release = [this](Node* n) {
+        while (n) {
+            Node* next = n->next;
+            if (!in_slab(n)) delete n;
+            n = next;
+        }
+    };
+    release(free_head_);
+    release(ready_head_);
+    if (slab_) VirtualFree(slab_, 0, MEM_RELEASE);
+}
@@ -0,0 +1,69 @@
+#include "FrameScanner.hpp"
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace {
+
+inline unsigned lowestBit(unsigned mask) {
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (unsigned)idx;
+}
+
+const std::uint8_t* findScalar(const std::uint8_t* p, const std::uint8_t* end, std::uint8_t b) {
+    for (; p < end; ++p)
+        if (*p == b) return p;
+    return nullptr;
+}
+
+const std::uint8_t* findSse2(const std::uint8_t* p, const std::uint8_t* end, std::uint8_t b) {
+    const __m128i needle = _mm_set1_epi8((char)b);
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+        if (m) return p + lowestBit(m);
+    }
+    return findScalar(p, end, b);
+}
+
+// MSVC emits AVX2 for the intrinsics regardless of /arch; we only call this
+// after the runtime check below.
+const std::uint8_t* findAvx2(const std::uint8_t* p, const std::uint8_t* end, std::uint8_t b) {
+    const __m256i needle = _mm256_set1_epi8((char)b);
+    for (; end - p >= 64; p += 64) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        unsigned ma = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, needle));
+        unsigned mc = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, needle));
+        if (ma) return p + lowestBit(ma);
+        if (mc) return p + 32 + lowestBit(mc);
+    }
+    return findSse2(p, end, b);
+}
+
+bool cpuHasAvx2() {
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+    __cpuid(r, 1);
+    const bool osxsave = (r[2] & (1 << 27)) != 0;
+    const bool avx     = (r[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;   // OS saves XMM+YMM state
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+}
+
+using FindFn = const std::uint8_t* (*)(const std::uint8_t*, const std::uint8_t*, std::uint8_t);
+const bool   kAvx2 = cpuHasAvx2();
+const FindFn kFind = kAvx2 ? findAvx2 : findSse2;
+
+} // namespace
+
+const std::uint8_t* FrameScanner::findByte(const std::uint8_t* p, const std::uint8_t* end, std::uint8_t b) {
+    // In the aligned steady state the start byte is right at p: skip the SIMD setup.
+    if (p < end && *p == b) return p;
+    return kFind(p, end, b);
+}
+
+const char* FrameScanner::kernelName() { return kAvx2 ? "avx2" : "sse2"; }
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Delimiter-based framing for devices that send `$` + payload + `#` style
+// frames. Instead of trusting the stream to stay 100-byte aligned, every frame
+// must start with 'start' and have 'end' at offset frameLen-1; anything else is
+// skipped (and counted) until the next start byte, so one lost byte costs one
+// frame instead of misaligning the rest of the session.
+class FrameScanner {
+public:
+    FrameScanner(std::uint8_t start, std::uint8_t end, std::size_t frameLen)
+        : start_(start), end_(end), len_(frameLen) {}
+
+    // Scan buf[0..n) and call sink(const uint8_t* frame) for every valid frame
+    // (frame points into buf, frameLen bytes). Returns how many bytes were
+    // consumed; the caller keeps buf[consumed..n) (always < frameLen bytes)
+    // and prepends it to the next chunk.
+    template <class Sink>
+    std::size_t scan(const std::uint8_t* buf, std::size_t n, Sink&& sink) {
+        std::size_t i = 0;
+        for (;;) {
+            const std::uint8_t* s = findByte(buf + i, buf + n, start_);
+            if (!s) { junk_ += n - i; return n; }
+            junk_ += (std::size_t)(s - (buf + i));
+            i = (std::size_t)(s - buf);
+            if (n - i < len_) return i;        // partial frame: wait for more bytes
+            if (buf[i + len_ - 1] == end_) {
+                sink(buf + i);
+                ++frames_;
+                i += len_;
+            } else {
+                ++malformed_;                  // resync on the next start byte
+                ++i;
+            }
+        }
+    }
+
+    std::size_t   frameLen()  const { return len_; }
+    std::uint64_t frames()    const { return frames_; }
+    std::uint64_t malformed() const { return malformed_; }
+    std::uint64_t junkBytes() const { return junk_; }
+
+    // First occurrence of 'b' in [p, end), or nullptr. Uses AVX2 when the CPU
+    // and OS support it, SSE2 otherwise (always present on x64).
+    static const std::uint8_t* findByte(const std::uint8_t* p, const std::uint8_t* end, std::uint8_t b);
+
+    // "avx2" or "sse2" — which kernel findByte() dispatches to.
+    static const char* kernelName();
+
+private:
+    std::uint8_t  start_;
+    std::uint8_t  end_;
+    std::size_t   len_;
+    std::uint64_t frames_{0};
+    std::uint64_t malformed_{0};
+    std::uint64_t junk_{0};
+};
@@ -1,5 +1,12 @@
 #include "ListenerThread.hpp"
+#include "FrameScanner.hpp"
+#include "RioIngest.hpp"
+#include "UdpIngest.hpp"
+#include "StripeReassembler.hpp"
+#include "AllocTrack.hpp"
+#include <cstring>
 #include <iostream>
+#include <vector>
 
 ListenerThread::ListenerThread(unsigned short port, DoubleListPool& pool)
     : port_(port), pool_(pool) {}
@@ -20,7 +27,17 @@ void ListenerThread::cleanupWinsock() {
 }
 
 bool ListenerThread::bindAndListen() {
-    listen_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (rio_) {
+        // Accepted sockets inherit the flag RIO needs.
+        listen_ = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, nullptr, 0,
+                             WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO);
+        if (listen_ == INVALID_SOCKET) {
+            std::cerr << "[listener] registered I/O not supported (" << WSAGetLastError()
+                      << "), using recv()\n";
+            rio_ = false;
+        }
+    }
+    if (!rio_) listen_ = ::socket(AF_INET, SOCK_STREAM, 0);
     if (listen_ == INVALID_SOCKET) { std::cerr << "[listener] socket() failed\n"; return false; }
 
     int yes = 1;
@@ -35,7 +52,7 @@ bool ListenerThread::bindAndListen() {
         std::cerr << "[listener] bind failed: " << WSAGetLastError() << "\n";
         return false;
     }
-    if (::listen(listen_, 1) == SOCKET_ERROR) {
+    if (::listen(listen_, striped_ ? SOMAXCONN : 1) == SOCKET_ERROR) {
         std::cerr << "[listener] listen failed: " << WSAGetLastError() << "\n";
         return false;
     }
@@ -43,11 +60,63 @@ bool ListenerThread::bindAndListen() {
     return true;
 }
 
+bool ListenerThread::bindUdp() {
+    if (rio_) {
+        listen_ = WSASocketW(AF_INET, SOCK_DGRAM, IPPROTO_UDP, nullptr, 0,
+                             WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO);
+        if (listen_ == INVALID_SOCKET) {
+            std::cerr << "[listener] registered I/O not supported (" << WSAGetLastError()
+                      << "), using recv()\n";
+            rio_ = false;
+        }
+    }
+    if (!rio_) listen_ = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (listen_ == INVALID_SOCKET) { std::cerr << "[listener] socket() failed\n"; return false; }
+
+    // No flow control on UDP: the socket buffer is all that rides out a stall.
+    int rcvbuf = (int)(udp_rcvbuf_kb_ * 1024);
+    setsockopt(listen_, SOL_SOCKET, SO_RCVBUF, (const char*)&rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_in a{};
+    a.sin_family      = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    a.sin_port        = htons(port_);
+    if (::bind(listen_, (sockaddr*)&a, sizeof a) == SOCKET_ERROR) {
+        std::cerr << "[listener] bind failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
+    std::cout << "[listener] udp on 127.0.0.1:" << port_ << "\n";
+    return true;
+}
+
 bool ListenerThread::start() {
     if (running_.exchange(true)) return true; // already running
 
+    if (framing_.delimited &&
+        (framing_.frameLen < 2 || framing_.frameLen > DoubleListPool::kPayload)) {
+        std::cerr << "[listener] frame length must be 2.." << DoubleListPool::kPayload << "\n";
+        running_.store(false);
+        return false;
+    }
+    if (udp_ && framing_.delimited) {
+        std::cout << "[listener] udp carries whole 100-byte frames, delimited framing ignored\n";
+        framing_.delimited = false;
+    }
+    if (resume_ && (udp_ || striped_ || framing_.delimited || rio_)) {
+        std::cout << "[listener] session resume uses plain recv() on one TCP client, fixed records\n";
+        udp_ = striped_ = rio_ = framing_.delimited = false;
+    }
+    if (striped_ && (udp_ || framing_.delimited || rio_)) {
+        std::cout << "[listener] striped mode uses plain recv() on TCP, fixed records\n";
+        udp_ = rio_ = framing_.delimited = false;
+    }
+    if (rio_ && framing_.delimited) {
+        std::cout << "[listener] registered I/O is for fixed framing only, using recv()\n";
+        rio_ = false;
+    }
+
     if (!initWinsock()) { running_.store(false); return false; }
-    if (!bindAndListen()){ cleanupWinsock(); running_.store(false); return false; }
+    if (!(udp_ ? bindUdp() : bindAndListen())) { cleanupWinsock(); running_.store(false); return false; }
 
     th_ = std::thread(&ListenerThread::threadMain, this);
     return true;
@@ -58,6 +127,11 @@ void ListenerThread::stop() {
     // Closing sockets unblocks accept()/recv()
     if (listen_ != INVALID_SOCKET) closesocket(listen_);
     if (client_ != INVALID_SOCKET) closesocket(client_);
+    {
+        std::lock_guard<std::mutex> lk(stripes_mx_);
+        for (SOCKET s : stripes_) closesocket(s);
+        stripes_.clear();
+    }
     if (th_.joinable()) th_.join();
     cleanupWinsock();
     // Make sure downstream knows we're done
@@ -93,13 +167,8 @@ bool ListenerThread::recvAll(void* buf, std::size_t len) {
     return got == len;
 }
 
-void ListenerThread::threadMain() {
-    // Accept exactly one client
-    if (!acceptOne()) {
-        pool_.close();
-        return;
-    }
-
+void ListenerThread::recvFixed() {
+    alloctrack::LoopCheck allocs("listener");
     // Main recv loop: fetch 100B at a time and hand off to pool
     while (running_.load()) {
         // Obtain a free node (allocates if free-list empty)
@@ -118,8 +187,329 @@ void ListenerThread::threadMain() {
             pool_.addFree(node);
             break;
         }
+        allocs.tick();
+    }
+}
+
+void ListenerThread::recvDelimited() {
+    // Pull large chunks and let the scanner find frame boundaries; only the
+    // tail of an incomplete frame (< frameLen bytes) is carried between recvs.
+    FrameScanner scanner(framing_.start, framing_.end, framing_.frameLen);
+    const std::size_t len = framing_.frameLen;
+    std::vector<std::uint8_t> buf(framing_.recvBuffer + len);
+    std::size_t fill = 0;
+    bool ok = true;
+
+    std::cout << "[listener] delimited framing (" << FrameScanner::kernelName() << "), frame "
+              << len << " bytes\n";
+    alloctrack::LoopCheck allocs("listener");
+
+    while (ok && running_.load()) {
+        int n = ::recv(client_, reinterpret_cast<char*>(buf.data() + fill),
+                       (int)(buf.size() - fill), 0);
+        if (n <= 0) break; // closed or error
+        fill += (std::size_t)n;
+
+        std::size_t used = scanner.scan(buf.data(), fill, [&](const std::uint8_t* frame) {
+            if (!ok) return;
+            DoubleListPool::Node* node = pool_.getFree();
+            if (!node) { ok = false; return; } // pool closed
+            std::memcpy(node->data.data(), frame, len);
+            if (len < node->data.size())
+                std::memset(node->data.data() + len, 0, node->data.size() - len);
+            if (!pool_.addNode(node)) { pool_.addFree(node); ok = false; }
+            allocs.tick();
+        });
+        std::memmove(buf.data(), buf.data() + used, fill - used);
+        fill -= used;
     }
 
+    std::cout << "[listener] frames " << scanner.frames() << ", malformed " << scanner.malformed()
+              << ", skipped bytes " << scanner.junkBytes() << "\n";
+}
+
+void ListenerThread::recvRio() {
+    {
+        RioIngest rio(pool_, running_, rio_depth_);
+        const bool ok = rio.init(client_);
+        if (ok) {
+            rio.run();
+            std::cout << "[rio] " << rio.completed() << " completions in " << rio.batches()
+                      << " batches, " << rio.zeroCopy() << " zero-copy / " << rio.copied()
+                      << " copied packets\n";
+        }
+        if (ok || rio.armed()) {
+            // Cancel receives still pointing into pool nodes before ~RioIngest recycles them.
+            closesocket(client_);
+            client_ = INVALID_SOCKET;
+            return;
+        }
+    }
+    std::cerr << "[listener] registered I/O setup failed, using recv()\n";
+    recvFixed();
+}
+
+void ListenerThread::recvUdp() {
+    UdpIngest udp(pool_, running_, rio_depth_);
+    if (rio_ && udp.initRio(listen_)) {
+        udp.runRio();
+    } else if (rio_ && udp.armed()) {
+        std::cerr << "[listener] registered I/O setup failed after posting receives\n";
+    } else {
+        if (rio_) std::cerr << "[listener] registered I/O setup failed, using recv()\n";
+        udp.runRecv(listen_);
+    }
+    // Cancel receives still pointing into UdpIngest's buffer before it is freed.
+    if (udp.armed() && listen_ != INVALID_SOCKET) {
+        closesocket(listen_);
+        listen_ = INVALID_SOCKET;
+    }
+    udp.report();
+}
+
+namespace {
+constexpr ULONGLONG kStripeAcceptMs = 3000;   // wait for the other striped connections this long
+}
+
+void ListenerThread::recvStriped() {
+    auto readHello = [](SOCKET s, unsigned& idx, unsigned& count) {
+        DWORD timeout = 1000;   // a connection that never says hello must not hold up the loop
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof timeout);
+        std::uint8_t h[StripeReassembler::kHelloBytes];
+        std::size_t got = 0;
+        while (got < sizeof h) {
+            int n = ::recv(s, reinterpret_cast<char*>(h) + got, (int)(sizeof h - got), 0);
+            if (n <= 0) return false;
+            got += (std::size_t)n;
+        }
+        timeout = 0;
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof timeout);
+        std::uint32_t magic;
+        std::memcpy(&magic, h, 4);
+        idx   = (unsigned)(h[4] | h[5] << 8);
+        count = (unsigned)(h[6] | h[7] << 8);
+        return magic == StripeReassembler::kHelloMagic && count >= 1 && idx < count;
+    };
+
+    unsigned idx = 0, count = 0;
+    if (!readHello(client_, idx, count)) {
+        std::cerr << "[listener] striped mode: bad hello on the first connection\n";
+        return;
+    }
+    std::vector<SOCKET> socks(count, INVALID_SOCKET);
+    socks[idx] = client_;
+    // The sender opens its connections back to back; one that hasn't come by
+    // the deadline (it failed, or the sender is gone) isn't waited for.
+    const ULONGLONG deadline = GetTickCount64() + kStripeAcceptMs;
+    unsigned have = 1;
+    while (have < count && running_.load()) {
+        const ULONGLONG now = GetTickCount64();
+        if (now >= deadline) {
+            std::cerr << "[listener] striped mode: " << have << " of " << count
+                      << " connections arrived, going on without the rest\n";
+            break;
+        }
+        fd_set r;
+        FD_ZERO(&r);
+        FD_SET(listen_, &r);
+        const ULONGLONG left = deadline - now;
+        timeval tv{(long)(left / 1000), (long)(left % 1000) * 1000};
+        const int ready = ::select(0, &r, nullptr, nullptr, &tv);
+        if (ready == SOCKET_ERROR) break;   // stop() closed the socket
+        if (ready == 0) continue;
+        SOCKET s = ::accept(listen_, nullptr, nullptr);
+        if (s == INVALID_SOCKET) break;
+        unsigned i = 0, c = 0;
+        if (!readHello(s, i, c) || c != count || socks[i] != INVALID_SOCKET) {
+            std::cerr << "[listener] striped mode: unexpected connection dropped\n";
+            closesocket(s);
+            continue;
+        }
+        int rcvbuf = 512 * 1024;
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&rcvbuf, sizeof(rcvbuf));
+        std::lock_guard<std::mutex> lk(stripes_mx_);
+        if (!running_.load()) { closesocket(s); break; }
+        socks[i] = s;
+        stripes_.push_back(s);
+        ++have;
+    }
+    std::cout << "[listener] striped over " << have << " connections, reorder window "
+              << stripe_window_ << " frames\n";
+
+    // One reader per connection; the reassembler puts frames back in order.
+    StripeReassembler re(pool_, stripe_window_);
+    std::vector<std::thread> readers;
+    for (SOCKET s : socks) {
+        if (s == INVALID_SOCKET) continue;
+        readers.emplace_back([this, s, &re] {
+            std::vector<std::uint8_t> buf(64 * 1024 + StripeReassembler::kRecord);
+            std::size_t fill = 0;
+            alloctrack::LoopCheck allocs("listener");
+            while (running_.load()) {
+                int n = ::recv(s, reinterpret_cast<char*>(buf.data() + fill), (int)(buf.size() - fill), 0);
+                if (n <= 0) break;   // closed or error; a cut-off record is dropped
+                fill += (std::size_t)n;
+                std::size_t off = 0;
+                for (; fill - off >= StripeReassembler::kRecord; off += StripeReassembler::kRecord) {
+                    std::uint64_t seq;
+                    std::memcpy(&seq, buf.data() + off, 8);
+                    if (!re.put(seq, buf.data() + off + 8)) return;   // pool closed
+                    allocs.tick();
+                }
+                std::memmove(buf.data(), buf.data() + off, fill - off);
+                fill -= off;
+            }
+        });
+    }
+    for (auto& t : readers) t.join();
+    re.finish();
+    std::cout << "[listener] striped: " << re.delivered() << " frames in order, " << re.skipped()
+              << " skipped, " << re.late() << " late, reorder peak " << re.maxHeld() << " frames\n";
+
+    std::lock_guard<std::mutex> lk(stripes_mx_);
+    for (SOCKET s : stripes_) closesocket(s);
+    stripes_.clear();
+}
+
+namespace {
+constexpr std::uint32_t kResumeMagic = 0x314D5352;   // "RSM1"
+constexpr std::uint32_t kResumeNew   = 1;            // reply flag: session not known, counting from 0
+}
+
+// Hello {u32 'RSM1', u32 0, u64 session}; reply {u32 'RSM1', u32 flags, u64 frames
+// of that session received so far}. A different session id starts over at 0.
+bool ListenerThread::resumeHello(SOCKET s, std::uint64_t& session, std::uint64_t& have) {
+    DWORD timeout = 1000;   // a connection that never says hello must not hold up the loop
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof timeout);
+    std::uint8_t h[16];
+    std::size_t got = 0;
+    while (got < sizeof h) {
+        int n = ::recv(s, reinterpret_cast<char*>(h) + got, (int)(sizeof h - got), 0);
+        if (n <= 0) return false;
+        got += (std::size_t)n;
+    }
+    timeout = 0;
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof timeout);
+
+    std::uint32_t magic;
+    std::uint64_t id;
+    std::memcpy(&magic, h, 4);
+    std::memcpy(&id, h + 8, 8);
+    if (magic != kResumeMagic) return false;
+    std::uint32_t flags = 0;
+    if (id != session) {
+        session = id;
+        have = 0;
+        flags = kResumeNew;
+    }
+    std::memcpy(h + 4, &flags, 4);
+    std::memcpy(h + 8, &have, 8);
+    return ::send(s, reinterpret_cast<const char*>(h), (int)sizeof h, 0) == (int)sizeof h;
+}
+
+void ListenerThread::recvResume() {
+    constexpr std::size_t kRec = DoubleListPool::kPayload;
+    std::vector<std::uint8_t> buf(64 * 1024 + kRec);
+    std::size_t fill = 0;
+    std::uint64_t session = 0, have = 0;
+    unsigned connects = 0, resumes = 0;
+    ULONGLONG lost_at = 0;
+    bool ended = false;
+    alloctrack::LoopCheck allocs("listener");
+
+    auto drop = [&](const char* why) {
+        closesocket(client_);
+        client_ = INVALID_SOCKET;
+        fill = 0;   // a cut-off frame is resent whole
+        lost_at = GetTickCount64();
+        std::cout << "[listener] " << why << " at frame " << have << ", waiting for the sender to resume\n";
+    };
+
+    // One thread, select() over the listening socket and the current client: a
+    // reconnect is taken even while the old connection hasn't noticed it is dead.
+    while (!ended && running_.load()) {
+        fd_set r;
+        FD_ZERO(&r);
+        FD_SET(listen_, &r);
+        if (client_ != INVALID_SOCKET) FD_SET(client_, &r);
+        if (::select(0, &r, nullptr, nullptr, nullptr) == SOCKET_ERROR) break;   // stop() closed them
+
+        if (FD_ISSET(listen_, &r)) {
+            SOCKET s = ::accept(listen_, nullptr, nullptr);
+            if (s == INVALID_SOCKET) break;
+            const std::uint64_t prev = session;
+            if (!resumeHello(s, session, have)) {
+                std::cerr << "[listener] resume: connection without a valid hello dropped\n";
+                closesocket(s);
+                continue;
+            }
+            int rcvbuf = 512 * 1024;
+            setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&rcvbuf, sizeof(rcvbuf));
+            if (client_ != INVALID_SOCKET) closesocket(client_);   // superseded by the reconnect
+            client_ = s;
+            fill = 0;
+            if (connects++ && session == prev) {
+                ++resumes;
+                std::cout << "[listener] session resumed at frame " << have;
+                if (lost_at) std::cout << ", " << (GetTickCount64() - lost_at) << " ms after the drop";
+                std::cout << "\n";
+            } else {
+                std::cout << "[listener] session " << std::hex << session << std::dec << " started\n";
+            }
+            lost_at = 0;
+            continue;
+        }
+        if (client_ == INVALID_SOCKET || !FD_ISSET(client_, &r)) continue;
+
+        int n = ::recv(client_, reinterpret_cast<char*>(buf.data() + fill), (int)(buf.size() - fill), 0);
+        if (n == 0) { ended = true; break; }            // graceful close: the sender is done
+        if (n < 0) { drop("connection lost"); continue; }
+        fill += (std::size_t)n;
+        std::size_t off = 0;
+        for (; fill - off >= kRec; off += kRec) {
+            DoubleListPool::Node* node = pool_.getFree();
+            if (!node) return;   // pool closed
+            std::memcpy(node->data.data(), buf.data() + off, kRec);
+            if (!pool_.addNode(node)) { pool_.addFree(node); return; }
+            ++have;
+            allocs.tick();
+        }
+        std::memmove(buf.data(), buf.data() + off, fill - off);
+        fill -= off;
+        // Acknowledge after every recv that completed frames: the sender frees its window with it.
+        if (off && ::send(client_, reinterpret_cast<const char*>(&have), (int)sizeof have, 0) != (int)sizeof have)
+            drop("ack failed");
+    }
+    std::cout << "[listener] session " << (ended ? "ended" : "stopped") << " after " << have << " frames, "
+              << resumes << " resumes\n";
+}
+
+void ListenerThread::threadMain() {
+    // From the thread itself, before its first instruction of real work.
+    applyPlacement(GetCurrentThread(), placement_);
+    if (udp_) {
+        recvUdp();
+        pool_.close();
+        return;
+    }
+
+    if (resume_) {
+        recvResume();
+        pool_.close();
+        return;
+    }
+
+    // Accept exactly one client
+    if (!acceptOne()) {
+        pool_.close();
+        return;
+    }
+
+    if (striped_)                recvStriped();
+    else if (framing_.delimited) recvDelimited();
+    else if (rio_)               recvRio();
+    else                         recvFixed();
+
     // Signal end-of-stream to consumer
     pool_.close();
 
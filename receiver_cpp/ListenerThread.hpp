@@ -4,6 +4,9 @@
 #include <string>
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
@@ -13,6 +16,16 @@
 #pragma comment(lib, "ws2_32.lib")
 
 #include "DoubleListPool.hpp" // pool with Node{ std::array<uint8_t,100> data; }
+#include "ThreadPlacement.hpp"
+
+// How the TCP byte stream is cut into packets.
+struct Framing {
+    bool          delimited  = false;   // false: blind kPayload-byte chunks
+    std::uint8_t  start      = '$';
+    std::uint8_t  end        = '#';
+    std::size_t   frameLen   = DoubleListPool::kPayload; // incl. both delimiters, <= kPayload
+    std::size_t   recvBuffer = 64 * 1024;                // bytes per recv() in delimited mode
+};
 
 class ListenerThread {
 public:
@@ -25,13 +38,55 @@ public:
     // Stop (idempotent): signal thread to exit, close sockets to unblock, join.
     void stop();
 
+    // Optional: CPU affinity / priority / name for the listener thread (call before start()).
+    void setPlacement(const ThreadPlacement& p) { placement_ = p; }
+
+    // Optional: delimiter-aware framing instead of fixed 100-byte chunks (call before start()).
+    void setFraming(const Framing& f) { framing_ = f; }
+
+    // Optional: receive through Registered I/O with 'depth' receives in flight
+    // (fixed framing only; falls back to recv() if RIO is unavailable).
+    void setRio(bool on, std::size_t depth) {
+        rio_ = on;
+        rio_depth_ = depth;
+    }
+
+    // Optional: take datagrams (see UdpIngest) on a UDP socket instead of one
+    // TCP client. setRio() then selects batched RIO receives. rcvBufKB sizes
+    // SO_RCVBUF, which is what absorbs bursts.
+    void setUdp(bool on, std::size_t rcvBufKB) {
+        udp_ = on;
+        udp_rcvbuf_kb_ = rcvBufKB;
+    }
+
+    // Optional: the sender stripes its stream over several TCP connections
+    // (see StripeReassembler); reorder up to 'window' frames.
+    void setStriped(bool on, std::size_t window) {
+        striped_ = on;
+        stripe_window_ = window;
+    }
+
+    // Optional: session resume. The sender opens every connection with a hello;
+    // frames are acknowledged, and after a dropped connection the same sender
+    // reconnects and continues from the last frame received. Only a graceful
+    // close ends the stream.
+    void setResume(bool on) { resume_ = on; }
+
 private:
     void threadMain();
     bool initWinsock();
     void cleanupWinsock();
     bool bindAndListen();
+    bool bindUdp();
     bool acceptOne();
     bool recvAll(void* buf, std::size_t len);
+    void recvFixed();
+    void recvDelimited();
+    void recvRio();
+    void recvUdp();
+    void recvStriped();
+    void recvResume();
+    bool resumeHello(SOCKET s, std::uint64_t& session, std::uint64_t& have);
 
 private:
     unsigned short      port_;
@@ -39,9 +94,20 @@ private:
 
     std::atomic<bool>   running_{false};
     std::thread         th_;
+    ThreadPlacement     placement_{};
+    Framing             framing_{};
+    bool                rio_{false};
+    std::size_t         rio_depth_{64};
+    bool                udp_{false};
+    std::size_t         udp_rcvbuf_kb_{8192};
+    bool                striped_{false};
+    std::size_t         stripe_window_{16384};
+    bool                resume_{false};
 
     // Winsock state
     bool                wsaInit_{false};
     SOCKET              listen_{INVALID_SOCKET};
     SOCKET              client_{INVALID_SOCKET};
+    std::mutex          stripes_mx_;
+    std::vector<SOCKET> stripes_;          // striped mode: the other connections
 };
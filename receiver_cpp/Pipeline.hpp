@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "DoubleListPool.hpp"
+
+// Compile-time packet pipelines.
+//
+// A stage is anything callable as StageResult(Packet&): a small struct, a
+// lambda, or another Pipeline. Pipeline<A, B, C> keeps its stages in a tuple
+// and calls them in order from an if-constexpr chain. There are no virtual
+// calls, so the whole chain inlines into the caller's loop. Stages may also
+// have start() (called before the first packet) and finish() (after the last).
+//
+//   auto p = makePipeline(ValidateStage{...}, StatsStage{stats}, write, PrintStage{100});
+//   p.start();  while (...) if (p(pkt) == StageResult::Stop) break;  p.finish();
+
+struct Packet {
+    std::uint8_t* data;    // DoubleListPool::kPayload bytes, stages may modify them
+    std::uint64_t index;   // arrival order, counted by whoever drives the pipeline
+};
+
+enum class StageResult {
+    Pass,   // hand the packet to the next stage
+    Drop,   // skip the remaining stages for this packet
+    Stop    // skip them and stop the pipeline
+};
+
+namespace pipeline_detail {
+template <class S, class = void> struct HasStart : std::false_type {};
+template <class S> struct HasStart<S, std::void_t<decltype(std::declval<S&>().start())>> : std::true_type {};
+template <class S, class = void> struct HasFinish : std::false_type {};
+template <class S> struct HasFinish<S, std::void_t<decltype(std::declval<S&>().finish())>> : std::true_type {};
+
+template <class S> void start(S& s)  { if constexpr (HasStart<S>::value) s.start(); }
+template <class S> void finish(S& s) { if constexpr (HasFinish<S>::value) s.finish(); }
+} // namespace pipeline_detail
+
+template <class... Stages>
+class Pipeline {
+public:
+    explicit Pipeline(Stages... s) : stages_(std::move(s)...) {}
+
+    StageResult operator()(Packet& p) { return run<0>(p); }
+
+    void start()  { std::apply([](auto&... s) { (pipeline_detail::start(s), ...); }, stages_); }
+    void finish() { std::apply([](auto&... s) { (pipeline_detail::finish(s), ...); }, stages_); }
+
+    template <std::size_t I> auto&       get()       { return std::get<I>(stages_); }
+    template <std::size_t I> const auto& get() const { return std::get<I>(stages_); }
+
+private:
+    template <std::size_t I>
+    StageResult run(Packet& p) {
+        if constexpr (I == sizeof...(Stages)) {
+            return StageResult::Pass;
+        } else {
+            const StageResult r = std::get<I>(stages_)(p);
+            if (r != StageResult::Pass) return r;
+            return run<I + 1>(p);
+        }
+    }
+
+    std::tuple<Stages...> stages_;
+};
+
+template <class... Stages>
+Pipeline<std::decay_t<Stages>...> makePipeline(Stages&&... s) {
+    return Pipeline<std::decay_t<Stages>...>(std::forward<Stages>(s)...);
+}
+
+// Runs 'Stage' on its own thread. Packets are copied into a single-producer /
+// single-consumer ring of Capacity slots and the caller carries on at once:
+// the outer pipeline sees Pass (or Stop once the stage has stopped). So the
+// stage's Drop can't affect the stages after it. Offload side-effect stages,
+// or a whole tail: Offload<Pipeline<...>>. A full ring blocks the producer;
+// nothing is dropped.
+template <class Stage, std::size_t Capacity = 4096>
+class Offload {
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static constexpr std::size_t kPayload = DoubleListPool::kPayload;
+
+public:
+    explicit Offload(Stage s) : stage_(std::move(s)) {}
+    Offload(Offload&& o) noexcept : stage_(std::move(o.stage_)) {}   // before start() only
+    ~Offload() { finish(); }
+
+    Offload(const Offload&) = delete;
+    Offload& operator=(const Offload&) = delete;
+    Offload& operator=(Offload&&) = delete;
+
+    void start() {
+        if (th_.joinable()) return;
+        ring_.reset(new Slot[Capacity]);
+        pipeline_detail::start(stage_);
+        th_ = std::thread(&Offload::consume, this);
+    }
+
+    StageResult operator()(Packet& p) {
+        if (stopped_.load(std::memory_order_relaxed)) return StageResult::Stop;
+        const std::uint64_t t = tail_.load(std::memory_order_relaxed);
+        std::uint64_t h = head_.load(std::memory_order_acquire);
+        while (t - h == Capacity) {
+            producerAsleep_.store(true);
+            h = head_.load();
+            if (t - h == Capacity) WaitOnAddress(&head_, &h, sizeof h, 10);
+            producerAsleep_.store(false, std::memory_order_relaxed);
+            h = head_.load(std::memory_order_acquire);
+            if (stopped_.load(std::memory_order_relaxed)) return StageResult::Stop;
+        }
+        Slot& s = ring_[t & (Capacity - 1)];
+        std::memcpy(s.data, p.data, kPayload);
+        s.index = p.index;
+        tail_.store(t + 1);   // seq_cst: ordered before the consumerAsleep_ check
+        if (consumerAsleep_.load()) WakeByAddressSingle(&tail_);
+        return StageResult::Pass;
+    }
+
+    // Drain what is queued, join the thread, then finish the stage.
+    void finish() {
+        if (!th_.joinable()) return;
+        closed_.store(true);
+        WakeByAddressSingle(&tail_);
+        th_.join();
+        pipeline_detail::finish(stage_);
+    }
+
+    Stage&       stage()       { return stage_; }
+    const Stage& stage() const { return stage_; }
+
+private:
+    struct Slot {
+        std::uint8_t  data[kPayload];
+        std::uint64_t index;
+    };
+
+    void consume() {
+        std::uint64_t h = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            std::uint64_t t = tail_.load(std::memory_order_acquire);
+            if (h == t) {
+                if (closed_.load()) {
+                    if (h == tail_.load(std::memory_order_acquire)) break;
+                    continue;
+                }
+                // The timeout only matters if a wake-up slipped between the checks.
+                consumerAsleep_.store(true);
+                t = tail_.load();
+                if (h == t && !closed_.load()) WaitOnAddress(&tail_, &t, sizeof t, 10);
+                consumerAsleep_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            for (; h != t; ++h) {
+                if (stopped_.load(std::memory_order_relaxed)) continue;   // just drain
+                Slot& s = ring_[h & (Capacity - 1)];
+                Packet p{s.data, s.index};
+                if (stage_(p) == StageResult::Stop) stopped_.store(true);
+            }
+            head_.store(h);
+            if (producerAsleep_.load()) WakeByAddressSingle(&head_);
+        }
+    }
+
+    Stage                    stage_;
+    std::unique_ptr<Slot[]>  ring_;
+    std::thread              th_;
+    alignas(64) std::atomic<std::uint64_t> tail_{0};   // producer
+    std::atomic<bool>        consumerAsleep_{false};
+    alignas(64) std::atomic<std::uint64_t> head_{0};   // consumer
+    std::atomic<bool>        producerAsleep_{false};
+    std::atomic<bool>        stopped_{false};
+    std::atomic<bool>        closed_{false};
+};
@@ -0,0 +1,251 @@
+#include "QueryServer.hpp"
+#include <afunix.h>
+#include <mswsock.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kRecord = DoubleListPool::kPayload;
+constexpr DWORD kTransmitChunk = 64u << 20;   // TransmitFile takes < 2 GB per call
+
+bool sendAll(SOCKET s, const char* p, std::size_t n) {
+    while (n) {
+        int w = ::send(s, p, (int)n, 0);
+        if (w <= 0) return false;
+        p += w; n -= (std::size_t)w;
+    }
+    return true;
+}
+
+bool sendLine(SOCKET s, const char* fmt, unsigned long long a = 0, unsigned long long b = 0) {
+    char line[128];
+    int n = std::snprintf(line, sizeof line, fmt, a, b);
+    return n > 0 && sendAll(s, line, (std::size_t)n);
+}
+
+// Sends file bytes [off, off+len). Tries TransmitFile first; once it fails
+// (e.g. not supported on AF_UNIX), the connection sticks to ReadFile + send.
+class FileSender {
+public:
+    FileSender(SOCKET s, HANDLE f) : s_(s), f_(f) {
+        GUID id = WSAID_TRANSMITFILE;
+        DWORD got = 0;
+        if (WSAIoctl(s, SIO_GET_EXTENSION_FUNCTION_POINTER, &id, sizeof id,
+                     &transmit_, sizeof transmit_, &got, nullptr, nullptr) != 0)
+            transmit_ = nullptr;
+    }
+
+    bool send(std::uint64_t off, std::uint64_t len) {
+        while (len) {
+            LARGE_INTEGER pos;
+            pos.QuadPart = (LONGLONG)off;
+            if (!SetFilePointerEx(f_, pos, nullptr, FILE_BEGIN)) return false;
+            DWORD n = len > kTransmitChunk ? kTransmitChunk : (DWORD)len;
+            if (transmit_ && transmit_(s_, f_, n, 0, nullptr, nullptr, 0)) {
+                off += n; len -= n;
+                continue;
+            }
+            transmit_ = nullptr;
+            if (buf_.empty()) buf_.resize(256 * 1024);
+            if (n > buf_.size()) n = (DWORD)buf_.size();
+            DWORD got = 0;
+            if (!ReadFile(f_, buf_.data(), n, &got, nullptr) || got != n) return false;
+            if (!sendAll(s_, buf_.data(), got)) return false;
+            off += got; len -= got;
+        }
+        return true;
+    }
+
+    bool zeroCopy() const { return transmit_ != nullptr; }
+
+private:
+    SOCKET             s_;
+    HANDLE             f_;
+    LPFN_TRANSMITFILE  transmit_{nullptr};
+    std::vector<char>  buf_;
+};
+
+// True if the peer closed its end (a FOLLOW client has nothing else to say).
+bool peerGone(SOCKET s) {
+    fd_set r; FD_ZERO(&r); FD_SET(s, &r);
+    timeval tv{0, 0};
+    if (select(0, &r, nullptr, nullptr, &tv) != 1) return false;
+    char c;
+    return ::recv(s, &c, 1, MSG_PEEK) <= 0;
+}
+
+bool readLine(SOCKET s, char* line, std::size_t cap) {
+    std::size_t n = 0;
+    while (n + 1 < cap) {
+        int r = ::recv(s, line + n, 1, 0);
+        if (r <= 0) return false;
+        if (line[n] == '\n') break;
+        if (line[n] != '\r') ++n;
+    }
+    line[n] = 0;
+    return true;
+}
+
+} // namespace
+
+QueryServer::QueryServer(std::string endpoint, const WriterThread& writer)
+    : endpoint_(std::move(endpoint)), writer_(writer) {}
+
+QueryServer::~QueryServer() { stop(); }
+
+bool QueryServer::fail() {
+    if (listen_ != INVALID_SOCKET) closesocket(listen_);
+    listen_ = INVALID_SOCKET;
+    WSACleanup();
+    wsaInit_ = false;
+    running_.store(false);
+    return false;
+}
+
+bool QueryServer::start() {
+    if (running_.exchange(true)) return true;
+    WSADATA w;
+    if (WSAStartup(MAKEWORD(2,2), &w) != 0) { running_.store(false); return false; }
+    wsaInit_ = true;
+
+    unixSocket_ = endpoint_.compare(0, 4, "tcp:") != 0;
+    if (unixSocket_) {
+        listen_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un a{};
+        a.sun_family = AF_UNIX;
+        if (endpoint_.size() >= sizeof a.sun_path) {
+            std::cerr << "[query] socket path too long\n";
+            return fail();
+        }
+        std::memcpy(a.sun_path, endpoint_.c_str(), endpoint_.size() + 1);
+        DeleteFileA(endpoint_.c_str());   // stale socket file from an earlier run
+        if (listen_ == INVALID_SOCKET || ::bind(listen_, (sockaddr*)&a, sizeof a) == SOCKET_ERROR) {
+            std::cerr << "[query] AF_UNIX bind failed (" << WSAGetLastError() << "), try --query tcp:PORT\n";
+            return fail();
+        }
+    } else {
+        listen_ = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in a{};
+        a.sin_family      = AF_INET;
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        a.sin_port        = htons((unsigned short)std::atoi(endpoint_.c_str() + 4));
+        if (listen_ == INVALID_SOCKET || ::bind(listen_, (sockaddr*)&a, sizeof a) == SOCKET_ERROR) {
+            std::cerr << "[query] bind " << endpoint_ << " failed: " << WSAGetLastError() << "\n";
+            return fail();
+        }
+    }
+    if (::listen(listen_, SOMAXCONN) == SOCKET_ERROR) {
+        std::cerr << "[query] listen failed: " << WSAGetLastError() << "\n";
+        return fail();
+    }
+    std::cout << "[query] serving " << writer_.outPath() << " on " << endpoint_ << "\n";
+    acceptTh_ = std::thread(&QueryServer::acceptLoop, this);
+    return true;
+}
+
+void QueryServer::stop() {
+    if (!running_.exchange(false)) return;
+    if (listen_ != INVALID_SOCKET) closesocket(listen_);
+    if (acceptTh_.joinable()) acceptTh_.join();
+    listen_ = INVALID_SOCKET;
+    {
+        std::lock_guard<std::mutex> lk(mx_);
+        for (Client& c : clients_) ::shutdown(c.sock, SD_BOTH);   // unblocks send/recv
+    }
+    for (Client& c : clients_) {
+        if (c.th.joinable()) c.th.join();
+        closesocket(c.sock);
+    }
+    clients_.clear();
+    if (unixSocket_) DeleteFileA(endpoint_.c_str());
+    if (wsaInit_) { WSACleanup(); wsaInit_ = false; }
+}
+
+void QueryServer::reapFinished() {
+    std::lock_guard<std::mutex> lk(mx_);
+    for (auto it = clients_.begin(); it != clients_.end();) {
+        if (it->done.load()) {
+            it->th.join();
+            closesocket(it->sock);
+            it = clients_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void QueryServer::acceptLoop() {
+    while (running_.load()) {
+        SOCKET s = ::accept(listen_, nullptr, nullptr);
+        if (s == INVALID_SOCKET) break;   // listener closed by stop()
+        reapFinished();
+        std::lock_guard<std::mutex> lk(mx_);
+        clients_.emplace_back();
+        Client& c = clients_.back();
+        c.sock = s;
+        c.th = std::thread(&QueryServer::serve, this, std::ref(c));
+    }
+}
+
+void QueryServer::serve(Client& c) {
+    const SOCKET s = c.sock;
+    char line[128];
+    HANDLE f = INVALID_HANDLE_VALUE;
+
+    if (!readLine(s, line, sizeof line)) { c.done.store(true); return; }
+    unsigned long long a = 0, b = 0;
+
+    if (!std::strcmp(line, "INFO")) {
+        std::uint64_t bytes = writer_.committedBytes();
+        sendLine(s, "OK packets %llu bytes %llu\n", bytes / kRecord, bytes);
+        c.done.store(true);
+        return;
+    }
+
+    const bool range  = std::sscanf(line, "RANGE %llu %llu", &a, &b) == 2;
+    const bool follow = !range && std::sscanf(line, "FOLLOW %llu", &a) == 1;
+    if (range || follow) {
+        // The writer's FILE* allows shared reads; we never read past the watermark.
+        f = CreateFileA(writer_.outPath().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (f == INVALID_HANDLE_VALUE) {
+            sendLine(s, "ERR cannot open output file\n");
+            c.done.store(true);
+            return;
+        }
+    }
+    FileSender out(s, f);
+
+    if (range) {
+        const std::uint64_t have = writer_.committedBytes() / kRecord;
+        const std::uint64_t first = a < have ? a : have;
+        const std::uint64_t count = b < have - first ? b : have - first;
+        if (sendLine(s, "OK %llu %llu\n", first, count))
+            out.send(first * kRecord, count * kRecord);
+    } else if (follow) {
+        std::uint64_t off = a - a % kRecord;
+        if (sendLine(s, "OK %llu\n", off)) {
+            while (running_.load()) {
+                const std::uint64_t end = writer_.committedBytes();
+                if (off < end) {
+                    if (!out.send(off, end - off)) break;
+                    off = end;
+                    continue;
+                }
+                if (writer_.finished() || peerGone(s)) break;   // stream over / client left
+                writer_.waitCommitted(end, 200);
+            }
+        }
+    } else {
+        sendLine(s, "ERR expected RANGE <first> <count> | FOLLOW <offset> | INFO\n");
+    }
+
+    if (f != INVALID_HANDLE_VALUE) CloseHandle(f);
+    ::shutdown(s, SD_SEND);
+    c.done.store(true);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+
+#include "WriterThread.hpp"
+
+// Read-while-write access to the writer's raw output file for local clients.
+// One text command per connection:
+//
+//   RANGE <first> <count>   ->  "OK <first> <count>\n" + count * 100 bytes
+//   FOLLOW <byteOffset>     ->  "OK <offset>\n" + records as they are committed,
+//                                until the client leaves or the stream ends
+//   INFO                    ->  "OK packets <n> bytes <n>\n"
+//   anything else           ->  "ERR <reason>\n"
+//
+// Only bytes below the writer's committed watermark are served, so a client
+// never sees a torn record. Data goes out with TransmitFile (the kernel copies
+// straight from the file cache), or ReadFile + send where the socket type
+// doesn't support it.
+class QueryServer {
+public:
+    // endpoint: an AF_UNIX socket path ("receiver.sock") or "tcp:PORT" for loopback TCP.
+    QueryServer(std::string endpoint, const WriterThread& writer);
+    ~QueryServer();
+
+    bool start();
+    void stop();   // closes the listener and every client, joins all threads
+
+private:
+    struct Client {
+        SOCKET            sock{INVALID_SOCKET};
+        std::thread       th;
+        std::atomic<bool> done{false};
+    };
+
+    void acceptLoop();
+    void serve(Client& c);
+    void reapFinished();
+    bool fail();   // undo a partial start()
+
+    std::string          endpoint_;
+    const WriterThread&  writer_;
+    bool                 unixSocket_{true};
+    bool                 wsaInit_{false};
+    SOCKET               listen_{INVALID_SOCKET};
+    std::atomic<bool>    running_{false};
+    std::thread          acceptTh_;
+    std::mutex           mx_;
+    std::list<Client>    clients_;
+};
@@ -0,0 +1,170 @@
+#include "RioIngest.hpp"
+#include "AllocTrack.hpp"
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr std::size_t kPayload = DoubleListPool::kPayload;
+constexpr ULONG       kDequeueBatch = 64;
+}
+
+RioIngest::RioIngest(DoubleListPool& pool, const std::atomic<bool>& running, std::size_t depth)
+    : pool_(pool), running_(running), depth_(depth ? depth : 1) {}
+
+RioIngest::~RioIngest() {
+    // Pending receives were cancelled when the socket closed; the request
+    // queue goes with the socket.
+    if (cq_ != RIO_INVALID_CQ) rio_.RIOCloseCompletionQueue(cq_);
+    if (slab_id_ != RIO_INVALID_BUFFERID) rio_.RIODeregisterBuffer(slab_id_);
+    if (bounce_id_ != RIO_INVALID_BUFFERID) rio_.RIODeregisterBuffer(bounce_id_);
+    if (event_) CloseHandle(event_);
+    for (Slot& s : slots_)
+        if (s.node) pool_.addFree(s.node);
+    if (carry_) pool_.addFree(carry_);
+    if (bounce_) VirtualFree(bounce_, 0, MEM_RELEASE);
+}
+
+bool RioIngest::init(SOCKET s) {
+    GUID id = WSAID_MULTIPLE_RIO;
+    DWORD got = 0;
+    rio_.cbSize = sizeof(rio_);
+    if (WSAIoctl(s, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &id, sizeof(id),
+                 &rio_, sizeof(rio_), &got, nullptr, nullptr) != 0) {
+        std::cerr << "[rio] function table unavailable: " << WSAGetLastError() << "\n";
+        return false;
+    }
+
+    // Buffers that ever receive data: the slab (direct) and a small bounce area.
+    if (pool_.slabBase()) {
+        slab_id_ = rio_.RIORegisterBuffer(static_cast<char*>(pool_.slabBase()), (DWORD)pool_.slabBytes());
+        if (slab_id_ == RIO_INVALID_BUFFERID)
+            std::cerr << "[rio] slab registration failed: " << WSAGetLastError() << " (bounce only)\n";
+    }
+    bounce_ = static_cast<std::uint8_t*>(
+        VirtualAlloc(nullptr, depth_ * kPayload, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    if (!bounce_) return false;
+    bounce_id_ = rio_.RIORegisterBuffer(reinterpret_cast<char*>(bounce_), (DWORD)(depth_ * kPayload));
+    if (bounce_id_ == RIO_INVALID_BUFFERID) {
+        std::cerr << "[rio] RIORegisterBuffer failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
+
+    event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!event_) return false;
+    RIO_NOTIFICATION_COMPLETION nc{};
+    nc.Type = RIO_EVENT_COMPLETION;
+    nc.Event.EventHandle = event_;
+    nc.Event.NotifyReset = TRUE;
+    cq_ = rio_.RIOCreateCompletionQueue((DWORD)depth_, &nc);
+    if (cq_ == RIO_INVALID_CQ) {
+        std::cerr << "[rio] RIOCreateCompletionQueue failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
+    rq_ = rio_.RIOCreateRequestQueue(s, (ULONG)depth_, 1, 1, 1, cq_, cq_, nullptr);
+    if (rq_ == RIO_INVALID_RQ) {
+        std::cerr << "[rio] RIOCreateRequestQueue failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
+
+    // Fill the request queue; one commit for the whole batch.
+    slots_.resize(depth_);
+    for (std::size_t i = 0; i < depth_; ++i) {
+        assign(slots_[i], i);
+        if (!post(i, RIO_MSG_DEFER)) return false;
+    }
+    if (!rio_.RIOReceive(rq_, nullptr, 0, RIO_MSG_COMMIT_ONLY, nullptr)) return false;
+
+    std::cout << "[rio] registered I/O: " << depth_ << " receives in flight, slab "
+              << (slab_id_ != RIO_INVALID_BUFFERID ? "registered" : "not registered") << "\n";
+    return true;
+}
+
+void RioIngest::assign(Slot& s, std::size_t i) {
+    // Prefer a slab node so a full completion can be handed over without a copy.
+    // Only a free slab node will do (never grow the pool here): if none is free,
+    // use this slot's bounce buffer instead.
+    s.node = nullptr;
+    if (slab_id_ != RIO_INVALID_BUFFERID) {
+        DoubleListPool::Node* n = pool_.tryGetSlabNode();
+        if (n) {
+            s.node = n;
+            s.buf  = n->data.data();
+            s.rb   = {slab_id_, (ULONG)(s.buf - static_cast<std::uint8_t*>(pool_.slabBase())), (ULONG)kPayload};
+            return;
+        }
+    }
+    s.buf = bounce_ + i * kPayload;
+    s.rb  = {bounce_id_, (ULONG)(i * kPayload), (ULONG)kPayload};
+}
+
+bool RioIngest::post(std::size_t i, DWORD flags) {
+    if (rio_.RIOReceive(rq_, &slots_[i].rb, 1, flags, reinterpret_cast<void*>(i))) return true;
+    std::cerr << "[rio] RIOReceive failed: " << WSAGetLastError() << "\n";
+    return false;
+}
+
+bool RioIngest::takeCarry() {
+    carry_ = pool_.getFree();
+    carry_len_ = 0;
+    return carry_ != nullptr;
+}
+
+bool RioIngest::absorb(const std::uint8_t* p, std::size_t n) {
+    while (n) {
+        if (!carry_ && !takeCarry()) return false;   // pool closed
+        std::size_t take = kPayload - carry_len_;
+        if (take > n) take = n;
+        std::memcpy(carry_->data.data() + carry_len_, p, take);
+        carry_len_ += take; p += take; n -= take;
+        if (carry_len_ == kPayload) {
+            DoubleListPool::Node* full = carry_;
+            carry_ = nullptr;
+            carry_len_ = 0;
+            if (!pool_.addNode(full)) { pool_.addFree(full); return false; }
+            ++copied_;
+        }
+    }
+    return true;
+}
+
+void RioIngest::run() {
+    RIORESULT res[kDequeueBatch];
+    bool ok = true;
+    alloctrack::LoopCheck allocs("listener");   // ticks per completion
+
+    while (ok && running_.load()) {
+        ULONG n = rio_.RIODequeueCompletion(cq_, res, kDequeueBatch);
+        if (n == RIO_CORRUPT_CQ) { std::cerr << "[rio] completion queue corrupt\n"; break; }
+        if (n == 0) {
+            // Arm the notification and sleep; the timeout re-checks running_.
+            rio_.RIONotify(cq_);
+            n = rio_.RIODequeueCompletion(cq_, res, kDequeueBatch);
+            if (n == 0) { WaitForSingleObject(event_, 100); continue; }
+            if (n == RIO_CORRUPT_CQ) break;
+        }
+        ++batches_;
+        completed_ += n;
+
+        for (ULONG k = 0; k < n && ok; ++k) {
+            const std::size_t i = (std::size_t)res[k].RequestContext;
+            Slot& s = slots_[i];
+            const std::size_t got = res[k].BytesTransferred;
+            if (res[k].Status != 0 || got == 0) { ok = false; break; }  // error or peer closed
+
+            if (got == kPayload && carry_len_ == 0 && s.node) {
+                // Aligned full packet already in a pool node: hand it over.
+                DoubleListPool::Node* full = s.node;
+                s.node = nullptr;
+                if (!pool_.addNode(full)) { pool_.addFree(full); ok = false; break; }
+                ++zero_copy_;
+                assign(s, i);
+            } else if (!absorb(s.buf, got)) {
+                ok = false;
+                break;
+            }
+            if (!post(i, RIO_MSG_DEFER)) ok = false;
+            allocs.tick();
+        }
+        if (ok && !rio_.RIOReceive(rq_, nullptr, 0, RIO_MSG_COMMIT_ONLY, nullptr)) ok = false;
+    }
+}
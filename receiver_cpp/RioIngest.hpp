@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <mswsock.h>
+
+#include "DoubleListPool.hpp"
+
+// Registered I/O receive engine (Windows' counterpart of io_uring with
+// provided buffers). The pool's slab is registered once, receives are posted
+// straight into free nodes, and completions are reaped in batches from one
+// completion queue — one kernel transition per batch instead of one recv()
+// per packet.
+//
+// A completion that fills a whole node while the stream is aligned is handed
+// to the writer as-is (zero copy). Short completions are copied into a carry
+// node until it holds kPayload bytes, exactly like recvAll().
+class RioIngest {
+public:
+    RioIngest(DoubleListPool& pool, const std::atomic<bool>& running, std::size_t depth);
+    ~RioIngest();
+
+    // Load the RIO function table for 's' (created with WSA_FLAG_REGISTERED_IO),
+    // register the buffers and post the first receives. false => use recv().
+    bool init(SOCKET s);
+
+    // Reap completions until the peer closes, an error occurs or 'running'
+    // drops. The caller must close the socket before destroying this object
+    // so no receive is still pending into pool memory.
+    void run();
+
+    // True once receives may have been posted (the socket can no longer be
+    // handed to plain recv(), even if init() failed afterwards).
+    bool armed() const { return rq_ != RIO_INVALID_RQ; }
+
+    std::uint64_t zeroCopy()  const { return zero_copy_; }   // nodes handed over without memcpy
+    std::uint64_t copied()    const { return copied_; }      // nodes assembled from short receives
+    std::uint64_t batches()   const { return batches_; }     // non-empty RIODequeueCompletion calls
+    std::uint64_t completed() const { return completed_; }
+
+private:
+    struct Slot {
+        DoubleListPool::Node* node{nullptr};   // receive target inside the slab, or
+        std::uint8_t*         buf{nullptr};    // a bounce buffer when no slab node was free
+        RIO_BUF               rb{};
+    };
+
+    void assign(Slot& s, std::size_t i);
+    bool post(std::size_t i, DWORD flags);
+    bool absorb(const std::uint8_t* p, std::size_t n);
+    bool takeCarry();
+
+    DoubleListPool&           pool_;
+    const std::atomic<bool>&  running_;
+    std::size_t               depth_;
+
+    RIO_EXTENSION_FUNCTION_TABLE rio_{};
+    RIO_BUFFERID   slab_id_{RIO_INVALID_BUFFERID};
+    RIO_BUFFERID   bounce_id_{RIO_INVALID_BUFFERID};
+    std::uint8_t*  bounce_{nullptr};           // depth * kPayload, VirtualAlloc'd
+    RIO_CQ         cq_{RIO_INVALID_CQ};
+    RIO_RQ         rq_{RIO_INVALID_RQ};
+    HANDLE         event_{nullptr};
+    std::vector<Slot> slots_;
+
+    DoubleListPool::Node* carry_{nullptr};
+    std::size_t           carry_len_{0};
+
+    std::uint64_t zero_copy_{0};
+    std::uint64_t copied_{0};
+    std::uint64_t batches_{0};
+    std::uint64_t completed_{0};
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+#include "Pipeline.hpp"
+#include "ChannelStats.hpp"
+
+// Reusable stages for Pipeline (see Pipeline.hpp).
+
+// Feed rolling per-channel stats (no-op without a ChannelStats).
+struct StatsStage {
+    ChannelStats* stats = nullptr;
+    StageResult operator()(Packet& p) const {
+        if (stats) stats->update(p.data, ChannelStats::nowSeconds());
+        return StageResult::Pass;
+    }
+};
+
+// Drop packets that aren't framed as start ... end over frameLen bytes.
+class ValidateStage {
+public:
+    ValidateStage() = default;
+    ValidateStage(bool enabled, std::uint8_t start, std::uint8_t end, std::size_t frameLen)
+        : enabled_(enabled), start_(start), end_(end), last_(frameLen ? frameLen - 1 : 0) {}
+
+    StageResult operator()(Packet& p) {
+        if (!enabled_ || (p.data[0] == start_ && p.data[last_] == end_)) return StageResult::Pass;
+        ++dropped_;
+        return StageResult::Drop;
+    }
+    bool          enabled() const { return enabled_; }
+    std::uint64_t dropped() const { return dropped_; }
+
+private:
+    bool          enabled_{false};
+    std::uint8_t  start_{'$'}, end_{'#'};
+    std::size_t   last_{DoubleListPool::kPayload - 1};
+    std::uint64_t dropped_{0};
+};
+
+// Keep the packets 'pred' accepts: filter([](const Packet& p) { return p.data[1] == 7; })
+template <class Pred>
+struct FilterStage {
+    Pred pred;
+    StageResult operator()(Packet& p) { return pred(static_cast<const Packet&>(p)) ? StageResult::Pass : StageResult::Drop; }
+};
+template <class Pred>
+FilterStage<std::decay_t<Pred>> filter(Pred&& pred) { return {std::forward<Pred>(pred)}; }
+
+// Compact console line for every Nth packet (printf: no allocation).
+struct PrintStage {
+    std::uint64_t every = 100;
+    StageResult operator()(Packet& p) const {
+        if (every && (p.index + 1) % every == 0)
+            std::printf("pkt#%llu first4 %02X %02X %02X %02X\n", (unsigned long long)p.index,
+                        p.data[0], p.data[1], p.data[2], p.data[3]);
+        return StageResult::Pass;
+    }
+};
@@ -0,0 +1,74 @@
+#include "StripeReassembler.hpp"
+#include <cstring>
+
+StripeReassembler::StripeReassembler(DoubleListPool& pool, std::size_t window)
+    : pool_(pool),
+      frames_((window ? window : 1) * DoubleListPool::kPayload),
+      used_(window ? window : 1, 0) {}
+
+bool StripeReassembler::put(std::uint64_t seq, const std::uint8_t* payload) {
+    std::lock_guard<std::mutex> lk(mx_);
+    const std::size_t w = used_.size();
+    if (seq < next_) {                       // given up on, or a duplicate
+        ++late_;
+        return !closed_;
+    }
+    if (seq >= next_ + w) skipTo(seq - w + 1);
+    if (seq >= end_) end_ = seq + 1;
+    if (seq == next_) {                      // in order: straight into a pool node
+        deliver(payload);
+        ++next_;
+        release();
+        return !closed_;
+    }
+    std::uint8_t& used = used_[seq % w];
+    if (used) {                              // duplicate inside the window
+        ++late_;
+        return !closed_;
+    }
+    std::memcpy(&frames_[(seq % w) * DoubleListPool::kPayload], payload, DoubleListPool::kPayload);
+    used = 1;
+    if (++held_ > max_held_) max_held_ = held_;
+    return !closed_;
+}
+
+void StripeReassembler::deliver(const std::uint8_t* payload) {
+    if (closed_) return;
+    DoubleListPool::Node* n = pool_.getFree();
+    if (!n) { closed_ = true; return; }
+    std::memcpy(n->data.data(), payload, DoubleListPool::kPayload);
+    if (!pool_.addNode(n)) {
+        pool_.addFree(n);
+        closed_ = true;
+        return;
+    }
+    ++delivered_;
+}
+
+void StripeReassembler::release() {
+    const std::size_t w = used_.size();
+    while (used_[next_ % w]) {
+        used_[next_ % w] = 0;
+        --held_;
+        deliver(&frames_[(next_ % w) * DoubleListPool::kPayload]);
+        ++next_;
+    }
+}
+
+void StripeReassembler::skipTo(std::uint64_t target) {
+    const std::size_t w = used_.size();
+    while (next_ < target) {
+        if (used_[next_ % w]) {
+            release();
+        } else {
+            ++skipped_;
+            ++next_;
+        }
+    }
+    release();
+}
+
+void StripeReassembler::finish() {
+    std::lock_guard<std::mutex> lk(mx_);
+    skipTo(end_);
+}
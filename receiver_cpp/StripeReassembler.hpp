@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "DoubleListPool.hpp"
+
+// In-order reassembly of one sender's frames striped over several TCP
+// connections. Each connection starts with a hello
+//
+//   u32 magic 'STRP' | u16 index | u16 count
+//
+// followed by records of u64 seq + 100-byte frame (little-endian). seq is
+// global across the connections.
+//
+// Connection threads put() frames in any order. Frames are handed to the pool
+// strictly by seq, and at most 'window' seqs past the oldest missing one are
+// held, in the reassembler's own preallocated window x 100 B buffer: a pool
+// node is only taken when a frame is handed over. A frame further ahead
+// means the gap has waited a whole window: the reassembler gives up on the
+// oldest missing seqs and counts them as skipped.
+// Seqs that arrive after that are counted as late and dropped. put() never
+// blocks, so a stalled connection can't stall the others.
+class StripeReassembler {
+public:
+    static constexpr std::uint32_t kHelloMagic = 0x50525453;   // "STRP"
+    static constexpr std::size_t   kHelloBytes = 8;
+    static constexpr std::size_t   kRecord     = 8 + DoubleListPool::kPayload;
+
+    StripeReassembler(DoubleListPool& pool, std::size_t window);
+
+    // Any connection thread. false once the pool is closed.
+    bool put(std::uint64_t seq, const std::uint8_t* payload);
+
+    // All connections are done: release what is held, counting remaining gaps.
+    void finish();
+
+    std::uint64_t delivered() const { return delivered_; }   // read after finish()
+    std::uint64_t skipped()   const { return skipped_; }
+    std::uint64_t late()      const { return late_; }
+    std::size_t   maxHeld()   const { return max_held_; }
+
+private:
+    void deliver(const std::uint8_t* payload);   // copy into a pool node, hand it over
+    void release();                       // hand over the in-order prefix
+    void skipTo(std::uint64_t target);    // give up on gaps below target
+
+    DoubleListPool&    pool_;
+    std::mutex         mx_;
+    std::vector<std::uint8_t> frames_;            // slot seq % window, 100 B each
+    std::vector<std::uint8_t> used_;              // 1 = slot holds a frame
+    std::uint64_t      next_{0};                  // oldest seq not yet handed over
+    std::uint64_t      end_{0};                   // 1 + highest seq seen
+    std::size_t        held_{0}, max_held_{0};
+    bool               closed_{false};
+    std::uint64_t      delivered_{0}, skipped_{0}, late_{0};
+};
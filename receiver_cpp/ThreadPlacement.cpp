@@ -0,0 +1,59 @@
+#include "ThreadPlacement.hpp"
+#include <cstdio>
+
+namespace {
+
+// SetThreadDescription exists from Windows 10 1607; resolve it at runtime so
+// the receiver still starts on older systems (the name is then just skipped).
+using SetThreadDescriptionFn = HRESULT (WINAPI*)(HANDLE, PCWSTR);
+
+bool setThreadName(HANDLE th, const char* name) {
+    static auto fn = reinterpret_cast<SetThreadDescriptionFn>(
+        reinterpret_cast<void*>(GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription")));
+    if (!fn || !name) return false;
+    wchar_t wname[64];
+    if (!MultiByteToWideChar(CP_UTF8, 0, name, -1, wname, 64)) return false;
+    return SUCCEEDED(fn(th, wname));
+}
+
+int lowestCpu(std::uint64_t mask) {
+    for (int i = 0; i < 64; ++i)
+        if (mask & (1ull << i)) return i;
+    return -1;
+}
+
+} // namespace
+
+int numaNodeOfMask(std::uint64_t cpuMask) {
+    int cpu = lowestCpu(cpuMask);
+    if (cpu < 0) return -1;
+    UCHAR node = 0;
+    if (!GetNumaProcessorNode(static_cast<UCHAR>(cpu), &node) || node == 0xFF) return -1;
+    return node;
+}
+
+bool applyPlacement(HANDLE th, const ThreadPlacement& p) {
+    const char* tag = p.name ? p.name : "thread";
+    bool ok = true;
+
+    bool named = setThreadName(th, p.name);
+
+    if (p.cpuMask && !SetThreadAffinityMask(th, static_cast<DWORD_PTR>(p.cpuMask))) {
+        std::fprintf(stderr, "[place] %s: SetThreadAffinityMask(0x%llx) failed (%lu)\n",
+                     tag, (unsigned long long)p.cpuMask, GetLastError());
+        ok = false;
+    }
+    if (p.priority != THREAD_PRIORITY_NORMAL && !SetThreadPriority(th, p.priority)) {
+        std::fprintf(stderr, "[place] %s: SetThreadPriority(%d) failed (%lu)\n",
+                     tag, p.priority, GetLastError());
+        ok = false;
+    }
+
+    // Report what is in effect, not what was asked for.
+    GROUP_AFFINITY ga{};
+    unsigned long long mask = GetThreadGroupAffinity(th, &ga) ? (unsigned long long)ga.Mask : 0;
+    int prio = GetThreadPriority(th);
+    std::printf("[place] %s: cpus 0x%llx, priority %d, numa node %d%s\n",
+                tag, mask, prio, numaNodeOfMask(mask), named ? "" : " (unnamed)");
+    return ok;
+}
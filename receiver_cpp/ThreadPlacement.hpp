@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+// Where and how a worker thread runs. Defaults leave everything to the scheduler.
+struct ThreadPlacement {
+    const char*   name     = nullptr;  // thread description (debugger / ETW / Process Explorer)
+    std::uint64_t cpuMask  = 0;        // affinity mask in processor group 0; 0 = any CPU
+    int           priority = THREAD_PRIORITY_NORMAL; // THREAD_PRIORITY_*; TIME_CRITICAL ~ SCHED_FIFO
+};
+
+// Apply name/affinity/priority to a thread, then print what the OS actually
+// accepted. Threads call it first thing with GetCurrentThread(), so none of
+// their work runs unplaced. Returns false if any requested setting was rejected.
+bool applyPlacement(HANDLE th, const ThreadPlacement& p);
+
+// NUMA node of the lowest CPU in 'cpuMask'; -1 if the mask is empty or unknown.
+int numaNodeOfMask(std::uint64_t cpuMask);
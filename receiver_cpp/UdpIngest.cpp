@@ -0,0 +1,183 @@
+#include "UdpIngest.hpp"
+#include "AllocTrack.hpp"
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+constexpr std::size_t kPayload      = DoubleListPool::kPayload;
+constexpr ULONG       kDequeueBatch = 64;
+
+inline std::uint16_t le16(const std::uint8_t* p) { return (std::uint16_t)(p[0] | p[1] << 8); }
+inline std::uint32_t le32(const std::uint8_t* p) {
+    return (std::uint32_t)p[0] | (std::uint32_t)p[1] << 8 | (std::uint32_t)p[2] << 16 | (std::uint32_t)p[3] << 24;
+}
+
+// Received-seq bitmap of a source (see Source::got).
+inline std::uint64_t& seqWord(UdpIngest::Source& s, std::uint32_t seq) {
+    return s.got[(seq % UdpIngest::kSeqWindow) / 64];
+}
+inline std::uint64_t seqBit(std::uint32_t seq) { return 1ull << (seq % 64); }
+}
+
+UdpIngest::UdpIngest(DoubleListPool& pool, const std::atomic<bool>& running, std::size_t depth)
+    : pool_(pool), running_(running), depth_(depth ? depth : 1) {}
+
+UdpIngest::~UdpIngest() {
+    if (cq_ != RIO_INVALID_CQ) rio_.RIOCloseCompletionQueue(cq_);
+    if (buf_id_ != RIO_INVALID_BUFFERID) rio_.RIODeregisterBuffer(buf_id_);
+    if (event_) CloseHandle(event_);
+    if (buf_) VirtualFree(buf_, 0, MEM_RELEASE);
+}
+
+bool UdpIngest::initRio(SOCKET s) {
+    GUID id = WSAID_MULTIPLE_RIO;
+    DWORD got = 0;
+    rio_.cbSize = sizeof(rio_);
+    if (WSAIoctl(s, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &id, sizeof(id),
+                 &rio_, sizeof(rio_), &got, nullptr, nullptr) != 0) {
+        std::cerr << "[udp] RIO function table unavailable: " << WSAGetLastError() << "\n";
+        return false;
+    }
+    buf_ = static_cast<std::uint8_t*>(
+        VirtualAlloc(nullptr, depth_ * kMaxDatagram, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    if (!buf_) return false;
+    buf_id_ = rio_.RIORegisterBuffer(reinterpret_cast<char*>(buf_), (DWORD)(depth_ * kMaxDatagram));
+    if (buf_id_ == RIO_INVALID_BUFFERID) {
+        std::cerr << "[udp] RIORegisterBuffer failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
+    event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!event_) return false;
+    RIO_NOTIFICATION_COMPLETION nc{};
+    nc.Type = RIO_EVENT_COMPLETION;
+    nc.Event.EventHandle = event_;
+    nc.Event.NotifyReset = TRUE;
+    cq_ = rio_.RIOCreateCompletionQueue((DWORD)depth_, &nc);
+    if (cq_ == RIO_INVALID_CQ) {
+        std::cerr << "[udp] RIOCreateCompletionQueue failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
+    rq_ = rio_.RIOCreateRequestQueue(s, (ULONG)depth_, 1, 1, 1, cq_, cq_, nullptr);
+    if (rq_ == RIO_INVALID_RQ) {
+        std::cerr << "[udp] RIOCreateRequestQueue failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
+    for (std::size_t i = 0; i < depth_; ++i)
+        if (!post(i, RIO_MSG_DEFER)) return false;
+    if (!rio_.RIOReceive(rq_, nullptr, 0, RIO_MSG_COMMIT_ONLY, nullptr)) return false;
+
+    std::cout << "[udp] registered I/O: " << depth_ << " receives in flight\n";
+    return true;
+}
+
+bool UdpIngest::post(std::size_t i, DWORD flags) {
+    RIO_BUF rb{buf_id_, (ULONG)(i * kMaxDatagram), (ULONG)kMaxDatagram};
+    if (rio_.RIOReceive(rq_, &rb, 1, flags, reinterpret_cast<void*>(i))) return true;
+    std::cerr << "[udp] RIOReceive failed: " << WSAGetLastError() << "\n";
+    return false;
+}
+
+bool UdpIngest::onDatagram(const std::uint8_t* p, std::size_t n) {
+    if (n < kHeader || (n - kHeader) % kPayload || le16(p) != kMagic || le16(p + 2) >= kMaxSources) {
+        ++bad_;
+        return true;
+    }
+    Source& src = sources_[le16(p + 2)];
+    const std::uint32_t seq = le32(p + 4);
+    if (src.ended) return true;   // repeated end marker
+    if (!src.seen) {
+        src.seen = true;
+        src.next = seq;
+        ++seen_;
+    }
+    const std::int32_t ahead = (std::int32_t)(seq - src.next);   // wraps with the counter
+    ++src.datagrams;
+    if (ahead >= 0) {
+        for (std::uint32_t k = 0; k < (std::uint32_t)ahead && k < kSeqWindow; ++k)
+            seqWord(src, src.next + k) &= ~seqBit(src.next + k);   // skipped: missing for now
+        src.lost += (std::uint32_t)ahead;
+        src.next = seq + 1;
+        seqWord(src, seq) |= seqBit(seq);
+    } else if (src.next - seq >= kSeqWindow) {
+        ++src.late;                       // too old to tell from a duplicate
+    } else if (seqWord(src, seq) & seqBit(seq)) {
+        ++src.dup;                        // already written
+        return true;
+    } else {
+        seqWord(src, seq) |= seqBit(seq);
+        ++src.late;
+        if (src.lost) --src.lost;         // it was counted when the gap opened
+    }
+
+    const std::size_t frames = (n - kHeader) / kPayload;
+    if (!frames) {
+        src.ended = true;
+        return ++ended_ < seen_;
+    }
+    for (std::size_t f = 0; f < frames; ++f) {
+        DoubleListPool::Node* node = pool_.getFree();
+        if (!node) return false;   // pool closed
+        std::memcpy(node->data.data(), p + kHeader + f * kPayload, kPayload);
+        if (!pool_.addNode(node)) { pool_.addFree(node); return false; }
+    }
+    src.frames += frames;
+    return true;
+}
+
+void UdpIngest::runRio() {
+    RIORESULT res[kDequeueBatch];
+    bool ok = true;
+    alloctrack::LoopCheck allocs("listener");   // ticks per datagram
+
+    while (ok && running_.load()) {
+        ULONG n = rio_.RIODequeueCompletion(cq_, res, kDequeueBatch);
+        if (n == RIO_CORRUPT_CQ) { std::cerr << "[udp] completion queue corrupt\n"; break; }
+        if (n == 0) {
+            rio_.RIONotify(cq_);
+            n = rio_.RIODequeueCompletion(cq_, res, kDequeueBatch);
+            if (n == 0) { WaitForSingleObject(event_, 100); continue; }
+            if (n == RIO_CORRUPT_CQ) break;
+        }
+        ++batches_;
+        completed_ += n;
+
+        for (ULONG k = 0; k < n && ok; ++k) {
+            const std::size_t i = (std::size_t)res[k].RequestContext;
+            if (res[k].Status == WSAEMSGSIZE) ++bad_;          // oversized datagram, truncated
+            else if (res[k].Status != 0) { ok = false; break; } // socket closed
+            else ok = onDatagram(buf_ + i * kMaxDatagram, res[k].BytesTransferred);
+            if (ok && !post(i, RIO_MSG_DEFER)) ok = false;
+            allocs.tick();
+        }
+        if (ok && !rio_.RIOReceive(rq_, nullptr, 0, RIO_MSG_COMMIT_ONLY, nullptr)) ok = false;
+    }
+}
+
+void UdpIngest::runRecv(SOCKET s) {
+    std::vector<std::uint8_t> buf(kMaxDatagram);
+    alloctrack::LoopCheck allocs("listener");
+    while (running_.load()) {
+        int n = ::recv(s, reinterpret_cast<char*>(buf.data()), (int)buf.size(), 0);
+        if (n == SOCKET_ERROR) {
+            if (WSAGetLastError() == WSAEMSGSIZE) { ++bad_; continue; }
+            break;   // socket closed by stop()
+        }
+        ++completed_;
+        if (!onDatagram(buf.data(), (std::size_t)n)) break;
+        allocs.tick();
+    }
+}
+
+void UdpIngest::report() const {
+    if (batches_)
+        std::cout << "[udp] " << completed_ << " datagrams in " << batches_ << " batches\n";
+    for (std::size_t i = 0; i < kMaxSources; ++i) {
+        const Source& s = sources_[i];
+        if (!s.seen) continue;
+        std::cout << "[udp] source " << i << ": " << s.datagrams << " datagrams, " << s.frames
+                  << " frames, lost " << s.lost << ", late " << s.late << ", duplicate " << s.dup
+                  << (s.ended ? "" : ", no end marker") << "\n";
+    }
+    if (bad_) std::cout << "[udp] " << bad_ << " malformed datagrams dropped\n";
+}
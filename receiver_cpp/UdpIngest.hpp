@@ -0,0 +1,86 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <mswsock.h>
+
+#include "DoubleListPool.hpp"
+
+// UDP ingest for loss-tolerant sources. Each datagram is
+//
+//   u16 magic 'UP' | u16 source | u32 seq | 1..kMaxFrames x 100-byte frames
+//
+// (little-endian; seq counts datagrams per source). A datagram with no frames
+// ends that source's stream; ingest stops once every source seen has ended.
+// Gaps in seq are counted as lost datagrams. A datagram that fills such a gap
+// within the last kSeqWindow seqs is late: it is delivered and taken off lost.
+// One seen before in that window is a duplicate and is dropped. Older ones
+// can't be told apart; they are delivered as late and stay counted as lost.
+//
+// With Registered I/O, 'depth' receives stay posted into one registered
+// buffer and up to 64 datagrams are reaped per RIODequeueCompletion call
+// (the Windows counterpart of recvmmsg). Otherwise it is one recv() each.
+class UdpIngest {
+public:
+    static constexpr std::uint16_t kMagic       = 0x5055;   // "UP"
+    static constexpr std::size_t   kHeader      = 8;
+    static constexpr std::size_t   kMaxFrames   = 14;       // 1408-byte datagrams fit a 1500 MTU
+    static constexpr std::size_t   kMaxDatagram = kHeader + kMaxFrames * DoubleListPool::kPayload;
+    static constexpr std::size_t   kMaxSources  = 256;      // source ids 0..255 are tracked
+    static constexpr std::uint32_t kSeqWindow   = 1024;     // recent seqs remembered per source
+
+    struct Source {
+        bool          seen{false};
+        bool          ended{false};
+        std::uint32_t next{0};        // expected seq
+        std::uint64_t datagrams{0};
+        std::uint64_t frames{0};
+        std::uint64_t lost{0};        // datagrams skipped over by a seq jump and not seen since
+        std::uint64_t late{0};        // seq behind the expected one, delivered
+        std::uint64_t dup{0};         // seq already received, dropped
+        // Received bits, seq % kSeqWindow, valid for (next - kSeqWindow, next).
+        std::array<std::uint64_t, kSeqWindow / 64> got{};
+    };
+
+    UdpIngest(DoubleListPool& pool, const std::atomic<bool>& running, std::size_t depth);
+    ~UdpIngest();
+
+    // Set up RIO receives on 's' (created with WSA_FLAG_REGISTERED_IO). false => runRecv().
+    bool initRio(SOCKET s);
+    // True once receives may have been posted ('s' can't fall back to recv()).
+    bool armed() const { return rq_ != RIO_INVALID_RQ; }
+
+    // Receive until every source has ended, the pool closes, the socket is
+    // closed or 'running' drops. Close the socket before destroying this
+    // object when runRio() was used.
+    void runRio();
+    void runRecv(SOCKET s);
+
+    void report() const;
+
+private:
+    bool onDatagram(const std::uint8_t* p, std::size_t n);   // false => stop
+    bool post(std::size_t i, DWORD flags);
+
+    DoubleListPool&           pool_;
+    const std::atomic<bool>&  running_;
+    std::size_t               depth_;
+
+    RIO_EXTENSION_FUNCTION_TABLE rio_{};
+    RIO_BUFFERID   buf_id_{RIO_INVALID_BUFFERID};
+    std::uint8_t*  buf_{nullptr};               // depth * kMaxDatagram, VirtualAlloc'd
+    RIO_CQ         cq_{RIO_INVALID_CQ};
+    RIO_RQ         rq_{RIO_INVALID_RQ};
+    HANDLE         event_{nullptr};
+
+    std::array<Source, kMaxSources> sources_{};
+    unsigned       seen_{0}, ended_{0};
+    std::uint64_t  bad_{0};                     // wrong magic / size / source id
+    std::uint64_t  batches_{0}, completed_{0};
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+// How a consumer waits for work when its queue is empty.
+enum class WaitStrategy {
+    Block,        // sleep on the condition variable right away (lowest CPU)
+    Spin,         // busy-poll with a pause instruction, never sleep (lowest latency)
+    SpinThenPark, // poll for a bounded number of iterations, then sleep
+};
+
+inline const char* waitStrategyName(WaitStrategy s) {
+    switch (s) {
+    case WaitStrategy::Block:        return "block";
+    case WaitStrategy::Spin:         return "spin";
+    case WaitStrategy::SpinThenPark: return "spin-then-park";
+    }
+    return "?";
+}
+
+// Counters kept by the pool; read them once the threads have stopped.
+struct WaitStats {
+    std::uint64_t spins          = 0; // pause iterations spent polling
+    std::uint64_t parks          = 0; // times the consumer actually slept
+    std::uint64_t wakeups        = 0; // notify calls issued by the producer
+    std::uint64_t wakeupsSkipped = 0; // notifies avoided because nobody was asleep
+    std::uint64_t wakeSamples    = 0; // parks that ended with a measured wake-up
+    std::uint64_t wakeTotalNs    = 0; // sum of notify -> running latencies
+    std::uint64_t wakeMaxNs      = 0;
+};
@@ -1,4 +1,6 @@
 #include "WriterThread.hpp"
+#include "AllocTrack.hpp"
+#include <cstring>
 
 WriterThread::WriterThread(DoubleListPool& pool, std::string outPath)
     : pool_(pool), outPath_(std::move(outPath)) {}
@@ -8,6 +10,19 @@ WriterThread::~WriterThread() { stop(); }
 bool WriterThread::start() {
     if (running_.exchange(true)) return true;
 
+    if (compressed_) {
+        blocks_ = std::make_unique<BlockWriter>(block_packets_, block_buffers_);
+        if (!blocks_->open(outPath_)) {
+            blocks_.reset();
+            running_.store(false);
+            return false;
+        }
+        th_ = std::thread(&WriterThread::threadMain, this);
+        return true;
+    }
+
+    if (threads_ > 1) return startParallel();
+
     fout_ = std::fopen(outPath_.c_str(), "ab");
     if (!fout_) {
         std::perror("[writer] fopen");
@@ -15,13 +30,17 @@ bool WriterThread::start() {
         return false;
     }
 
+    // Append mode: readers index packets from the start of the file, earlier runs included.
+    _fseeki64(fout_, 0, SEEK_END);
+    base_ = (std::uint64_t)_ftelli64(fout_);
+    committed_.store(base_, std::memory_order_release);
+    last_commit_ = GetTickCount64();
+
     // Give stdio a large buffer to minimize syscalls and blocking on disk
+    // (owned by this writer; freed in stop() after fclose)
     if (stdio_buf_kb_) {
-        std::size_t sz = stdio_buf_kb_ * 1024;
-        // static so lifetime outlives setvbuf usage; fine here since one writer per process
-        static std::vector<char> buf; 
-        buf.resize(sz);
-        std::setvbuf(fout_, buf.data(), _IOFBF, buf.size());
+        stdio_buf_.resize(stdio_buf_kb_ * 1024);
+        std::setvbuf(fout_, stdio_buf_.data(), _IOFBF, stdio_buf_.size());
     }
 
     th_ = std::thread(&WriterThread::threadMain, this);
@@ -32,48 +51,207 @@ void WriterThread::stop() {
     if (!running_.exchange(false)) return;
     // No direct signal to pool here — ListenerThread/pool controls closure.
     if (th_.joinable()) th_.join();
+    for (auto& w : workers_) if (w.joinable()) w.join();
+    workers_.clear();
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    if (dropped_) std::cout << "[writer] dropped " << dropped_ << " malformed packets\n";
     if (fout_) {
         std::fflush(fout_);
         std::fclose(fout_);
         fout_ = nullptr;
+        std::vector<char>().swap(stdio_buf_);
     }
+    if (blocks_) {
+        blocks_->close();
+        std::uint64_t raw = blocks_->rawBytes(), stored = blocks_->storedBytes();
+        std::cout << "[writer] " << blocks_->blocks() << " blocks, " << raw << " -> " << stored
+                  << " bytes (" << (stored ? (double)raw / (double)stored : 0.0) << "x)\n";
+        blocks_.reset();
+    }
+}
+// fflush only ever follows whole fwrite()s, so everything up to here is whole records.
+void WriterThread::commit() {
+    std::fflush(fout_);
+    last_commit_ = GetTickCount64();
+    committed_.store(base_ + count_ * DoubleListPool::kPayload, std::memory_order_release);
+    WakeByAddressAll(&committed_);
 }
+
+void WriterThread::waitCommitted(std::uint64_t seen, DWORD timeoutMs) const {
+    WaitOnAddress(const_cast<std::atomic<std::uint64_t>*>(&committed_), &seen, sizeof seen, timeoutMs);
+}
+
 void WriterThread::wait() {
     if (th_.joinable()) th_.join();
+    for (auto& w : workers_) if (w.joinable()) w.join();
 }
-void WriterThread::threadMain() {
+StageResult WriterThread::writePacket(Packet& p) {
+    // Append 100B (compressed mode: into the current block; never waits on compression)
+    if (blocks_) {
+        if (!blocks_->append(p.data)) {   // the helper's write failed: stop like a failed fwrite
+            std::fprintf(stderr, "[writer] block write failed, stopping\n");
+            return StageResult::Stop;
+        }
+    } else if (std::fwrite(p.data, 1, DoubleListPool::kPayload, fout_) != DoubleListPool::kPayload) {
+        std::perror("[writer] fwrite");
+        return StageResult::Stop;
+    }
+    ++count_;
+    if (fout_ && ((count_ % flush_every_) == 0 ||
+                  (pool_.readySize() == 0 && GetTickCount64() - last_commit_ >= commit_ms_))) {
+        commit();
+    }
+    return StageResult::Pass;
+}
+
+template <class StatsS>
+void WriterThread::runPipeline(StatsS stats) {
+    // The console line is throttled to avoid console overhead; printf into
+    // stdout's own buffer doesn't allocate, iostream formatting may.
+    auto pipeline = makePipeline(std::move(stats), validate_,
+                                 [this](Packet& p) { return writePacket(p); }, PrintStage{100});
+    alloctrack::LoopCheck allocs("writer");
+    pipeline.start();
+    std::uint64_t index = 0;
     while (running_.load()) {
         // Block until there is a ready node or pool is closed and drained.
-        DoubleListPool::Node* n = pool_.getNode();
+        // With records not yet committed, wait only until the commit interval
+        // is up, so a quiet link doesn't leave them unflushed.
+        DoubleListPool::Node* n;
+        if (fout_ && committed_.load(std::memory_order_relaxed) != base_ + count_ * DoubleListPool::kPayload) {
+            const ULONGLONG since = GetTickCount64() - last_commit_;
+            bool timedOut = false;
+            n = pool_.getNode(since >= commit_ms_ ? 0u : (unsigned)(commit_ms_ - since), timedOut);
+            if (timedOut) { commit(); continue; }
+        } else {
+            n = pool_.getNode();
+        }
         if (!n) break;  // pool closed + empty => we're done
 
-        // Append 100B
-        size_t w = std::fwrite(n->data.data(), 1, n->data.size(), fout_);
-        if (w != n->data.size()) {
-            std::perror("[writer] fwrite");
-            pool_.addFree(n); // return node before exiting
-            break;
-        }
+        Packet p{n->data.data(), index++};
+        const StageResult r = pipeline(p);
+        pool_.addFree(n);   // recycle node to free list (Offload stages copied it)
+        if (r == StageResult::Stop) break;
+        allocs.tick();
+    }
+    pipeline.finish();
+    dropped_ = pipeline.template get<1>().dropped();
+}
+
+void WriterThread::threadMain() {
+    // Placed before its first write or pool access, so nothing runs unpinned.
+    applyPlacement(GetCurrentThread(), placement_);
+    if (stats_ && stats_thread_) runPipeline(Offload<StatsStage>(StatsStage{stats_}));
+    else                         runPipeline(StatsStage{stats_});
+    if (fout_) commit();
+    finished_.store(true);
+}
+
+bool WriterThread::startParallel() {
+    // Overlapped so the workers' writes aren't serialized on the handle.
+    file_ = CreateFileA(outPath_.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+    LARGE_INTEGER size{};
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size)) {
+        std::fprintf(stderr, "[writer] cannot open %s (%lu)\n", outPath_.c_str(), GetLastError());
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+        running_.store(false);
+        return false;
+    }
+    // Same append semantics as "ab": this run's packet 0 goes at the current end.
+    base_ = (std::uint64_t)size.QuadPart;
+    committed_.store(base_, std::memory_order_release);
+    done_ = 0;
+    next_run_ = 0;
+    pending_.fill(0);
+    live_.store(threads_);
+    for (unsigned i = 0; i < threads_; ++i) workers_.emplace_back(&WriterThread::parallelMain, this);
+    std::printf("[writer] %u threads, runs of up to %zu packets\n", threads_, run_packets_);
+    if (validate_.enabled())   // a packet's offset is its arrival index: nothing can be dropped
+        std::printf("[writer] packet validation is off with parallel writers\n");
+    return true;
+}
 
-        // Print a compact line (throttled to avoid console overhead)
-        if ((++count_ % 100) == 0) {
-            auto &d = n->data;
-            std::ios::fmtflags f(std::cout.flags());
-            std::cout << "pkt#" << (count_-1) << " first4 "
-                      << std::hex << std::uppercase << std::setfill('0')
-                      << std::setw(2) << (int)d[0] << " "
-                      << std::setw(2) << (int)d[1] << " "
-                      << std::setw(2) << (int)d[2] << " "
-                      << std::setw(2) << (int)d[3]
-                      << std::dec << std::nouppercase << "\n";
-            std::cout.flags(f);
+// Runs can finish in any order; the watermark only moves over a gap-free prefix.
+// Returns false if a worker failed while this run waited for ring space.
+bool WriterThread::runDone(std::uint64_t run, std::uint64_t first, std::size_t n) {
+    std::unique_lock<std::mutex> lk(done_mx_);
+    done_cv_.wait(lk, [&]{ return run < next_run_ + kPendingRuns || failed_.load(); });
+    if (failed_.load()) return false;
+    pending_[run % kPendingRuns] = first + n;
+    if (run != next_run_) return true;   // past the gap: the run that closes it publishes
+    while (pending_[next_run_ % kPendingRuns]) {
+        std::uint64_t& end = pending_[next_run_ % kPendingRuns];
+        done_ = end;
+        end = 0;
+        ++next_run_;
+    }
+    count_ = (std::size_t)done_;
+    committed_.store(base_ + done_ * DoubleListPool::kPayload, std::memory_order_release);
+    WakeByAddressAll(&committed_);
+    lk.unlock();
+    done_cv_.notify_all();
+    return true;
+}
+
+void WriterThread::parallelMain() {
+    applyPlacement(GetCurrentThread(), placement_);
+    alloctrack::LoopCheck allocs("writer");
+    constexpr std::size_t kRec = DoubleListPool::kPayload;
+    std::vector<std::uint8_t> buf(run_packets_ * kRec);
+    OVERLAPPED ov{};
+    ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    while (running_.load() && !failed_.load()) {
+        DoubleListPool::Node* head = nullptr;
+        std::uint64_t seq = 0, run = 0;
+        const std::size_t n = pool_.getRun(head, run_packets_, seq, run);
+        if (!n) break;  // pool closed + empty => we're done
+
+        // Gather the run into one buffer, then hand the nodes straight back.
+        std::uint8_t* p = buf.data();
+        DoubleListPool::Node* tail = head;
+        for (DoubleListPool::Node* x = head; x; x = x->next, p += kRec) {
+            std::memcpy(p, x->data.data(), kRec);
+            tail = x;
         }
+        pool_.addFreeRun(head, tail, n);
 
-        if ((count_ % flush_every_) == 0) {
-            std::fflush(fout_);
+        if (stats_) {
+            std::lock_guard<std::mutex> lk(stats_mx_);
+            const std::int64_t now = ChannelStats::nowSeconds();
+            for (std::size_t i = 0; i < n; ++i) stats_->update(buf.data() + i * kRec, now);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::uint64_t idx = seq + i;
+            if ((idx + 1) % 100 == 0) {
+                const std::uint8_t* d = buf.data() + i * kRec;
+                std::printf("pkt#%llu first4 %02X %02X %02X %02X\n", (unsigned long long)idx, d[0], d[1], d[2], d[3]);
+            }
         }
 
-        // Recycle node to free list
-        pool_.addFree(n);
+        const std::uint64_t off = base_ + seq * kRec;
+        ov.Offset = (DWORD)off;
+        ov.OffsetHigh = (DWORD)(off >> 32);
+        DWORD written = 0;
+        BOOL ok = WriteFile(file_, buf.data(), (DWORD)(n * kRec), nullptr, &ov);
+        if (ok || GetLastError() == ERROR_IO_PENDING) ok = GetOverlappedResult(file_, &ov, &written, TRUE);
+        if (!ok || written != n * kRec) {
+            std::fprintf(stderr, "[writer] WriteFile at %llu failed (%lu)\n", (unsigned long long)off, GetLastError());
+            {
+                std::lock_guard<std::mutex> lk(done_mx_);
+                failed_.store(true);   // the watermark stays below the hole
+            }
+            done_cv_.notify_all();     // release workers waiting for ring space
+            break;
+        }
+        if (!runDone(run, seq, n)) break;
+        allocs.tick();
     }
+    CloseHandle(ov.hEvent);
+    if (live_.fetch_sub(1) == 1) finished_.store(true);
 }
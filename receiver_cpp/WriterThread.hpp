@@ -1,14 +1,21 @@
 #pragma once
+#include <array>
 #include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdio>
 #include <string>
 #include <thread>
 #include <vector>
-#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 
 #include "DoubleListPool.hpp"   // Node{ std::array<uint8_t,100> data; }
+#include "ThreadPlacement.hpp"
+#include "BlockStore.hpp"
+#include "ChannelStats.hpp"
+#include "Stages.hpp"
 
 class WriterThread {
 public:
@@ -22,12 +29,60 @@ public:
     // Requests shutdown and joins the thread. Idempotent.
     void stop();
     void wait();
+    // True once the loop has exited (pool closed and drained, or write error).
+    bool finished() const { return finished_.load(); }
+
+    // Raw mode: length of the output file known to hold only whole, flushed
+    // records (includes what earlier runs appended). Only grows; readers must
+    // not read past it.
+    std::uint64_t committedBytes() const { return committed_.load(std::memory_order_acquire); }
+    // Sleep until committedBytes() moves past 'seen' (or timeoutMs passes).
+    void waitCommitted(std::uint64_t seen, DWORD timeoutMs) const;
+    const std::string& outPath() const { return outPath_; }
+    std::size_t packets() const { return count_; }   // read after stop()
     // Optional tuning (call before start()):
     void setFlushEvery(std::size_t n) { flush_every_ = n ? n : 100; }
     void setStdioBufferKB(std::size_t kb) { stdio_buf_kb_ = kb; }
+    // When the pool runs empty, flush (and advance committedBytes) once the
+    // last flush is this old, even if no packet follows, so tail readers don't
+    // wait for flushEvery.
+    void setCommitIntervalMs(unsigned ms) { commit_ms_ = ms; }
+    void setPlacement(const ThreadPlacement& p) { placement_ = p; }
+    // Rolling per-channel stats updated for every packet before it is written.
+    // onThread: update them on a helper thread behind an SPSC ring instead.
+    void setStats(ChannelStats* s, bool onThread = false) {
+        stats_ = s;
+        stats_thread_ = onThread;
+    }
+    // Drop packets not framed as start ... end (frameLen bytes) instead of writing them.
+    void setValidation(bool dropMalformed, std::uint8_t start, std::uint8_t end, std::size_t frameLen) {
+        validate_ = ValidateStage(dropMalformed, start, end, frameLen);
+    }
+    // Raw mode with threads > 1: that many threads each take runs of up to
+    // runPackets consecutive packets and write them at their own file offset
+    // (packet i lives at i * 100). The file comes out byte-identical to the
+    // single-thread writer; committedBytes() only covers the gap-free prefix.
+    void setParallel(unsigned threads, std::size_t runPackets) {
+        threads_ = threads ? threads : 1;
+        run_packets_ = runPackets ? runPackets : 1;
+    }
+    // Block-compressed output (outPath + outPath.idx) instead of raw packets.
+    // maxBlocks bounds the block buffers; past it the writer waits for the compressor.
+    void setCompressed(bool on, std::size_t packetsPerBlock, std::size_t maxBlocks = 8) {
+        compressed_ = on;
+        block_packets_ = packetsPerBlock;
+        block_buffers_ = maxBlocks;
+    }
 
 private:
+    // Single-thread path: stats -> validate -> write -> console line (see Pipeline.hpp).
     void threadMain();
+    template <class StatsS> void runPipeline(StatsS stats);
+    StageResult writePacket(Packet& p);
+    void commit();
+    bool startParallel();
+    void parallelMain();
+    bool runDone(std::uint64_t run, std::uint64_t first, std::size_t n);
 
 private:
     DoubleListPool&    pool_;
@@ -35,8 +90,42 @@ private:
     std::FILE*         fout_{nullptr};
 
     std::atomic<bool>  running_{false};
+    std::atomic<bool>  finished_{false};
     std::thread        th_;
+    ThreadPlacement    placement_{};
     std::size_t        count_{0};       // packets written
     std::size_t        flush_every_{100};
     std::size_t        stdio_buf_kb_{1024}; // 1MB stdio buffer by default
+    std::vector<char>  stdio_buf_;
+    std::uint64_t      base_{0};            // file size before this run
+    std::atomic<std::uint64_t> committed_{0};
+    unsigned           commit_ms_{50};
+    ULONGLONG          last_commit_{0};
+
+    // Parallel raw mode
+    unsigned           threads_{1};
+    std::size_t        run_packets_{655};
+    HANDLE             file_{INVALID_HANDLE_VALUE};   // overlapped, shared by the workers
+    std::vector<std::thread> workers_;
+    std::atomic<unsigned> live_{0};
+    std::atomic<bool>  failed_{false};
+    std::mutex         stats_mx_;               // ChannelStats has a single writer
+    // Runs finished past a gap wait in a fixed ring, slot = run index % kPendingRuns,
+    // holding the run's end (0 = empty). A run that would land more than
+    // kPendingRuns ahead of the gap waits for the gap to close first.
+    static constexpr std::size_t kPendingRuns = 64;
+    std::mutex         done_mx_;                // guards done_ / next_run_ / pending_
+    std::condition_variable done_cv_;           // next_run_ moved (or a worker failed)
+    std::uint64_t      done_{0};                // packets [0, done_) are on disk
+    std::uint64_t      next_run_{0};            // index of the run that starts at done_
+    std::array<std::uint64_t, kPendingRuns> pending_{};
+
+    bool               compressed_{false};
+    std::size_t        block_packets_{655};  // 655 * 100B ~ 64 KB blocks
+    std::size_t        block_buffers_{8};
+    std::unique_ptr<BlockWriter> blocks_;
+    ChannelStats*      stats_{nullptr};
+    bool               stats_thread_{false};
+    ValidateStage      validate_{};
+    std::uint64_t      dropped_{0};
 };
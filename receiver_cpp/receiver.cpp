@@ -2,18 +2,301 @@
 #include "DoubleListPool.hpp"
 #include "ListenerThread.hpp"
 #include "WriterThread.hpp"
+#include "ThreadPlacement.hpp"
+#include "ChannelStats.hpp"
+#include "AllocTrack.hpp"
+#include "QueryServer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main() {
-    DoubleListPool pool(POOL_PREALLOC_NODES);
-    ListenerThread listener(LISTENER_PORT, pool);
-    WriterThread writer(pool, WRITER_OUTPUT_FILE);
+static double cpuSeconds() {
+    FILETIME c, e, k, u;
+    if (!GetProcessTimes(GetCurrentProcess(), &c, &e, &k, &u)) return 0.0;
+    auto ticks = [](const FILETIME& f) {
+        return (double)(((unsigned long long)f.dwHighDateTime << 32) | f.dwLowDateTime);
+    };
+    return (ticks(k) + ticks(u)) / 1e7; // 100ns units
+}
+
+static void reportWait(const char* label, const WaitStats& w, double wall, double cpu) {
+    std::printf("[%s] wait=%s: cpu %.2fs / wall %.2fs (%.0f%%), spins %llu, parks %llu, "
+                "wakeups %llu (skipped %llu), wake latency avg %.1fus max %.1fus\n",
+                label, waitStrategyName(POOL_WAIT_STRATEGY), cpu, wall, wall > 0 ? 100.0 * cpu / wall : 0.0,
+                (unsigned long long)w.spins, (unsigned long long)w.parks,
+                (unsigned long long)w.wakeups, (unsigned long long)w.wakeupsSkipped,
+                w.wakeSamples ? w.wakeTotalNs / 1e3 / w.wakeSamples : 0.0, w.wakeMaxNs / 1e3);
+}
+
+// One line per active channel: rate over each window, violations and the
+// first 4 byte offsets' min/max/mean over the last minute.
+static void printStats(const char* label, const ChannelStats& st) {
+    ChannelStats::Snapshot snap;
+    const std::int64_t now = ChannelStats::nowSeconds();
+    for (std::size_t ch = 0; ch < st.channels(); ++ch) {
+        if (!st.snapshot(ch, snap) || !snap.w[ChannelStats::Hour].packets) continue;
+        const ChannelStats::WindowStats& m = snap.w[ChannelStats::Minute];
+        // Snapshots roll on packet arrival; an idle second means nothing came in it.
+        const double r1s = now - snap.asOf > 1 ? 0.0 : snap.w[ChannelStats::Second].rate;
+        std::printf("[stats%s] ch %zu: %.1f / %.1f / %.1f pkt/s (1s/1m/1h), violations %llu / %llu / %llu",
+                    label, ch, r1s, m.rate, snap.w[ChannelStats::Hour].rate,
+                    (unsigned long long)snap.w[ChannelStats::Second].violations,
+                    (unsigned long long)m.violations,
+                    (unsigned long long)snap.w[ChannelStats::Hour].violations);
+        for (int i = 0; i < 4; ++i)
+            std::printf(", b%d %u/%u/%.1f", i, m.min[i], m.max[i], m.mean[i]);
+        std::printf("\n");
+    }
+}
+
+// One shared-nothing ingest lane: its own port, pool, listener, writer and file.
+struct Shard {
+    Shard(unsigned short port, const std::string& out, int numaNode)
+        : pool(POOL_PREALLOC_NODES, numaNode), listener(port, pool), writer(pool, out) {}
+    DoubleListPool pool;
+    ListenerThread listener;
+    WriterThread   writer;
+    std::unique_ptr<ChannelStats> stats;
+    std::unique_ptr<QueryServer>  query;   // declared after writer: destroyed first
+    std::string    listenerName, writerName;  // outlive the ThreadPlacement pointers
+};
+
+// packets.bin -> packets.shard2.bin (unchanged when there is a single shard)
+static std::string shardPath(const std::string& out, unsigned i, unsigned n) {
+    if (n == 1) return out;
+    std::string tag = ".shard" + std::to_string(i);
+    std::size_t dot = out.find_last_of('.');
+    std::size_t sep = out.find_last_of("/\\");
+    if (dot == std::string::npos || (sep != std::string::npos && dot < sep)) return out + tag;
+    return out.substr(0, dot) + tag + out.substr(dot);
+}
+
+// receiver.sock -> receiver.shard2.sock, tcp:7000 -> tcp:7002
+static std::string shardQuery(const std::string& q, unsigned i, unsigned n) {
+    if (q.compare(0, 4, "tcp:") == 0) return "tcp:" + std::to_string(std::atoi(q.c_str() + 4) + (int)i);
+    return shardPath(q, i, n);
+}
+
+// --alloc-check: a loopback client sending 'packets' frames at 'rate' pkt/s
+// (0 = as fast as possible), so the hot loops can be checked without a sender.
+static void loopbackLoad(unsigned short port, std::uint64_t packets, unsigned rate) {
+    SOCKET s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in a{};
+    a.sin_family      = AF_INET;
+    a.sin_port        = htons(port);
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (s == INVALID_SOCKET || ::connect(s, (sockaddr*)&a, sizeof a) == SOCKET_ERROR) {
+        std::printf("[load] connect to %u failed\n", (unsigned)port);
+        if (s != INVALID_SOCKET) closesocket(s);
+        return;
+    }
+    constexpr std::size_t kBurst = 100;
+    std::vector<char> buf(kBurst * DoubleListPool::kPayload);
+    for (std::size_t i = 0; i < buf.size(); ++i) buf[i] = (char)('A' + i % 26);
+    for (std::size_t f = 0; f < kBurst; ++f) {
+        buf[f * DoubleListPool::kPayload] = (char)FRAME_START_BYTE;
+        buf[f * DoubleListPool::kPayload + FRAME_LEN - 1] = (char)FRAME_END_BYTE;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::uint64_t sent = 0;
+    while (sent < packets) {
+        std::uint64_t due = packets;
+        if (rate) {
+            double el = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            due = (std::uint64_t)(el * rate) + 1;
+            if (due > packets) due = packets;
+            if (sent >= due) { Sleep(1); continue; }
+        }
+        std::size_t n = (std::size_t)(due - sent < kBurst ? due - sent : kBurst);
+        const char* p = buf.data();
+        int left = (int)(n * DoubleListPool::kPayload);
+        while (left > 0) {
+            int w = ::send(s, p, left, 0);
+            if (w <= 0) { std::printf("[load] send failed\n"); closesocket(s); return; }
+            p += w; left -= w;
+        }
+        sent += n;
+    }
+    ::shutdown(s, SD_SEND);
+    closesocket(s);
+    std::printf("[load] port %u: %llu packets sent\n", (unsigned)port, (unsigned long long)sent);
+}
+
+static HANDLE g_stop = nullptr;
+
+static BOOL WINAPI onConsoleCtrl(DWORD type) {
+    if (type != CTRL_C_EVENT && type != CTRL_BREAK_EVENT && type != CTRL_CLOSE_EVENT) return FALSE;
+    SetEvent(g_stop);
+    return TRUE;
+}
+
+int main(int argc, char** argv) {
+    unsigned short port = LISTENER_PORT;
+    std::string out = WRITER_COMPRESSED ? WRITER_COMPRESSED_FILE : WRITER_OUTPUT_FILE;
+    bool rio = LISTENER_RIO;
+    bool udp = LISTENER_UDP;
+    bool striped = LISTENER_STRIPED;
+    bool resume = LISTENER_RESUME;
+    unsigned nShards = RECEIVER_SHARDS;
+    unsigned nWriters = WRITER_THREADS;
+    std::uint64_t allocCheck = 0;   // packets of loopback load, 0 = normal run
+    unsigned allocRate = 20000;
+    bool outGiven = false;
+    std::string query = QUERY_ENABLED ? QUERY_SOCKET_PATH : "off";
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--port") && i + 1 < argc) port = (unsigned short)std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) { out = argv[++i]; outGiven = true; }
+        else if (!std::strcmp(argv[i], "--engine") && i + 1 < argc &&
+                 (!std::strcmp(argv[i + 1], "rio") || !std::strcmp(argv[i + 1], "classic")))
+            rio = !std::strcmp(argv[++i], "rio");
+        else if (!std::strcmp(argv[i], "--udp")) udp = true;
+        else if (!std::strcmp(argv[i], "--striped")) striped = true;
+        else if (!std::strcmp(argv[i], "--resume")) resume = true;
+        else if (!std::strcmp(argv[i], "--shards") && i + 1 < argc) nShards = (unsigned)std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--writers") && i + 1 < argc) nWriters = (unsigned)std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--query") && i + 1 < argc) query = argv[++i];
+        else if (!std::strcmp(argv[i], "--alloc-check") && i + 1 < argc) allocCheck = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--alloc-rate") && i + 1 < argc) allocRate = (unsigned)std::atoi(argv[++i]);
+        else {
+            std::printf("usage: receiver [--port N] [--out FILE] [--engine classic|rio] [--udp] [--striped] [--resume]\n"
+                        "                [--shards N] [--writers N] [--query PATH|tcp:PORT|off]\n"
+                        "                [--alloc-check PACKETS [--alloc-rate PKT_PER_S]]\n");
+            return 1;
+        }
+    }
+    if (allocCheck) {
+        if (!alloctrack::kCompiledIn) {
+            std::printf("--alloc-check needs a build with -DRECEIVER_ALLOC_TRACKING=ON\n");
+            return 1;
+        }
+        // The first 10% of packets may allocate (stdio buffers, pool growth, ...).
+        alloctrack::setWarmup(allocCheck / 10 > 1000 ? allocCheck / 10 : 1000);
+        if (udp || striped || resume) {
+            std::printf("--alloc-check drives a plain TCP client, drop --udp / --striped / --resume\n");
+            return 1;
+        }
+        if (!outGiven) out = "alloccheck.bin";
+    }
+    if (nShards < 1 || nShards > 64) { std::printf("--shards must be 1..64\n"); return 1; }
+    if (nWriters < 1 || nWriters > 64) { std::printf("--writers must be 1..64\n"); return 1; }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    auto stopAll = [&] {
+        // Closing a listener closes its pool; the writer drains what's left, then exits.
+        for (auto& s : shards) s->listener.stop();
+        for (auto& s : shards) { s->writer.wait(); s->writer.stop(); }
+        // Followers see the writer finish and leave on their own; stop() closes the rest.
+        for (auto& s : shards) if (s->query) s->query->stop();
+    };
+
+    for (unsigned i = 0; i < nShards; ++i) {
+        const bool pin = nShards > 1 && SHARD_PIN_CORES;
+        const unsigned long long lmask = pin ? 1ull << i : LISTENER_CPU_MASK;
+        const unsigned long long wmask = pin ? 1ull << i : WRITER_CPU_MASK;
+
+        // Pool memory is touched first by the listener, so keep it on the listener's node.
+        auto s = std::make_unique<Shard>((unsigned short)(port + i), shardPath(out, i, nShards),
+                                         numaNodeOfMask(lmask));
+        std::printf("[pool] %zu nodes preallocated, numa node %d\n", s->pool.freeSize(), s->pool.numaNode());
+        s->pool.setWaitStrategy(POOL_WAIT_STRATEGY, POOL_SPIN_LIMIT);
+        s->listenerName = nShards > 1 ? "listener" + std::to_string(i) : "listener";
+        s->writerName   = nShards > 1 ? "writer" + std::to_string(i) : "writer";
+
+        s->writer.setFlushEvery(WRITER_FLUSH_EVERY);
+        s->writer.setStdioBufferKB(WRITER_STDIO_BUFFER_KB);
+        s->writer.setCompressed(WRITER_COMPRESSED, WRITER_BLOCK_PACKETS, WRITER_BLOCK_BUFFERS);
+        s->writer.setCommitIntervalMs(WRITER_COMMIT_MS);
+        s->writer.setValidation(WRITER_DROP_MALFORMED, FRAME_START_BYTE, FRAME_END_BYTE, FRAME_LEN);
+        if (!WRITER_COMPRESSED) s->writer.setParallel(nWriters, WRITER_RUN_PACKETS);
+        s->listener.setPlacement({s->listenerName.c_str(), lmask, LISTENER_PRIORITY});
+        s->listener.setFraming({LISTENER_DELIMITED, FRAME_START_BYTE, FRAME_END_BYTE, FRAME_LEN, LISTENER_RECV_BUFFER});
+        s->listener.setRio(rio, LISTENER_RIO_DEPTH);
+        s->listener.setUdp(udp, LISTENER_UDP_RCVBUF_KB);
+        s->listener.setStriped(striped, STRIPE_REORDER_WINDOW);
+        s->listener.setResume(resume);
+        s->writer.setPlacement({s->writerName.c_str(), wmask, WRITER_PRIORITY});
+        if (STATS_ENABLED) {
+            s->stats = std::make_unique<ChannelStats>(ChannelStats::Config{
+                STATS_CHANNEL_OFFSET, STATS_CHANNELS, STATS_CHECK_PATTERN, FRAME_START_BYTE, FRAME_END_BYTE, FRAME_LEN});
+            s->writer.setStats(s->stats.get(), STATS_ON_THREAD);
+        }
+
+        if (!s->listener.start()) { stopAll(); return 1; }
+        if (!s->writer.start()) { s->listener.stop(); stopAll(); return 1; }
+        // Raw files only: block-compressed output is read with readBlockPacket() (scanner --packet).
+        if (query != "off" && !WRITER_COMPRESSED) {
+            s->query = std::make_unique<QueryServer>(shardQuery(query, i, nShards), s->writer);
+            if (!s->query->start()) s->query.reset();   // ingest keeps going without it
+        }
+        if (nShards > 1)
+            std::printf("[shard %u] port %u -> %s\n", i, (unsigned)(port + i), shardPath(out, i, nShards).c_str());
+        shards.push_back(std::move(s));
+    }
+
+    std::vector<std::thread> loaders;
+    for (unsigned i = 0; allocCheck && i < nShards; ++i)
+        loaders.emplace_back(loopbackLoad, (unsigned short)(port + i), allocCheck, allocRate);
+
+    // Run until every shard's client has gone (its writer drained) or Ctrl+C.
+    g_stop = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    SetConsoleCtrlHandler(onConsoleCtrl, TRUE);
+    auto t0 = std::chrono::steady_clock::now();
+    double cpu0 = cpuSeconds();
+    auto lastPrint = t0;
+    for (;;) {
+        bool done = true;
+        for (auto& s : shards) done = done && s->writer.finished();
+        if (done || WaitForSingleObject(g_stop, 100) == WAIT_OBJECT_0) break;
+
+        auto now = std::chrono::steady_clock::now();
+        if (STATS_ENABLED && STATS_PRINT_SECONDS && now - lastPrint >= std::chrono::seconds(STATS_PRINT_SECONDS)) {
+            lastPrint = now;
+            for (unsigned i = 0; i < nShards; ++i)
+                printStats(nShards > 1 ? (" " + std::to_string(i)).c_str() : "", *shards[i]->stats);
+        }
+    }
+    stopAll();
+    for (auto& t : loaders) t.join();
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double cpu = cpuSeconds() - cpu0;
 
-    writer.setFlushEvery(WRITER_FLUSH_EVERY);
-    writer.setStdioBufferKB(WRITER_STDIO_BUFFER_KB);
+    if (nShards == 1) {
+        reportWait("pool", shards[0]->pool.waitStats(), wall, cpu);
+    } else {
+        WaitStats sum{};
+        std::size_t packets = 0;
+        for (unsigned i = 0; i < nShards; ++i) {
+            WaitStats w = shards[i]->pool.waitStats();
+            std::printf("[shard %u] %zu packets, parks %llu, wakeups %llu\n", i, shards[i]->writer.packets(),
+                        (unsigned long long)w.parks, (unsigned long long)w.wakeups);
+            packets += shards[i]->writer.packets();
+            sum.spins += w.spins; sum.parks += w.parks;
+            sum.wakeups += w.wakeups; sum.wakeupsSkipped += w.wakeupsSkipped;
+            sum.wakeSamples += w.wakeSamples; sum.wakeTotalNs += w.wakeTotalNs;
+            if (w.wakeMaxNs > sum.wakeMaxNs) sum.wakeMaxNs = w.wakeMaxNs;
+        }
+        std::printf("[receiver] %u shards: %zu packets (%.0f pkt/s)\n", nShards, packets,
+                    wall > 0 ? packets / wall : 0.0);
+        reportWait("pool", sum, wall, cpu);
+    }
+    SetConsoleCtrlHandler(onConsoleCtrl, FALSE);
+    CloseHandle(g_stop);
 
-    if (!listener.start()) return 1;
-    if (!writer.start()) { listener.stop(); return 1; }
-    writer.wait();  
-    writer.stop();
-    listener.stop();
+    for (unsigned i = 0; i < nShards; ++i)
+        if (shards[i]->pool.grown())
+            std::printf("[pool] shard %u grew by %zu nodes beyond the preallocated %zu\n", i,
+                        shards[i]->pool.grown(), (std::size_t)POOL_PREALLOC_NODES);
+    if (allocCheck) {
+        alloctrack::report();
+        const bool clean = alloctrack::steadyStateClean();
+        std::printf("[alloc] steady state %s\n", clean ? "allocation-free" : "ALLOCATES");
+        return clean ? 0 : 2;
+    }
+    return 0;
 }
@@ -21,11 +21,11 @@ if not exist "%TX_EXE%" (
 )
 
 rem Start receiver
-start "receiver (emulator)" cmd /k ""%RX_EXE%" 
+start "receiver (emulator)" cmd /k ""%RX_EXE%" --port %PORT% --out %OUT%"
 rem Give receiver a moment to bind
 timeout /t 1 >nul
 
 rem Start sender (emulator)
-start "sender (emulator)" cmd /k ""%TX_EXE%" 
+start "sender (emulator)" cmd /k ""%TX_EXE%" --port %PORT% --baud %BAUD%"
 
 endlocal
@@ -0,0 +1,156 @@
+#include "Export.hpp"
+#include "Filters.hpp"
+#include "Parallel.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <intrin.h>
+#include <memory>
+
+namespace {
+
+constexpr char kCsvHeader[] = "index,payload_hex\n";
+constexpr std::size_t kCsvHeaderLen = sizeof(kCsvHeader) - 1;
+
+// Output file opened for overlapped I/O: positional writes from several
+// threads really run in parallel instead of serializing on the file object.
+class OutFile {
+public:
+    ~OutFile() { if (h_ != INVALID_HANDLE_VALUE) CloseHandle(h_); }
+
+    bool create(const std::string& path, std::uint64_t size) {
+        h_ = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+        if (h_ == INVALID_HANDLE_VALUE) {
+            std::fprintf(stderr, "[export] create %s failed (%lu)\n", path.c_str(), GetLastError());
+            return false;
+        }
+        // Size the file once so concurrent writes never extend it.
+        LARGE_INTEGER end{};
+        end.QuadPart = (LONGLONG)size;
+        if (!SetFilePointerEx(h_, end, nullptr, FILE_BEGIN) || !SetEndOfFile(h_)) {
+            std::fprintf(stderr, "[export] presize failed (%lu)\n", GetLastError());
+            return false;
+        }
+        return true;
+    }
+
+    bool writeAt(std::uint64_t off, const void* p, std::size_t n) const {
+        OVERLAPPED ov{};
+        ov.Offset     = (DWORD)off;
+        ov.OffsetHigh = (DWORD)(off >> 32);
+        ov.hEvent     = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        DWORD done = 0;
+        BOOL ok = WriteFile(h_, p, (DWORD)n, nullptr, &ov);
+        if (!ok && GetLastError() == ERROR_IO_PENDING) ok = TRUE;
+        if (ok) ok = GetOverlappedResult(h_, &ov, &done, TRUE);
+        CloseHandle(ov.hEvent);
+        if (!ok || done != n) {
+            std::fprintf(stderr, "[export] write at %llu failed (%lu)\n", (unsigned long long)off, GetLastError());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    HANDLE h_{INVALID_HANDLE_VALUE};
+};
+
+template <class Fn>
+void forEachMatch(const ChunkResult& c, Fn&& fn) {
+    for (std::size_t w = 0; w < c.bitmap.size(); ++w) {
+        for (std::uint64_t bits = c.bitmap[w]; bits; bits &= bits - 1) {
+            unsigned long b;
+            _BitScanForward64(&b, bits);
+            fn(c.first + w * 64 + b);
+        }
+    }
+}
+
+} // namespace
+
+bool exportCsv(const MappedFile& in, const std::vector<ChunkResult>& chunks,
+               const std::string& path, unsigned threads) {
+    std::vector<std::uint64_t> offset(chunks.size());
+    std::uint64_t total = kCsvHeaderLen;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        offset[i] = total;
+        total += chunks[i].csvBytes;
+    }
+
+    OutFile out;
+    if (!out.create(path, total) || !out.writeAt(0, kCsvHeader, kCsvHeaderLen)) return false;
+
+    constexpr std::size_t kBuf = 4 << 20;
+    std::vector<std::unique_ptr<char[]>> bufs(threads);
+    for (auto& b : bufs) b.reset(new char[kBuf]);
+    std::atomic<bool> ok{true};
+
+    parallelFor(chunks.size(), threads, [&](unsigned w, std::size_t ci) {
+        static const char hex[] = "0123456789abcdef";
+        char* buf = bufs[w].get();
+        std::size_t used = 0;
+        std::uint64_t at = offset[ci];
+        auto flush = [&] {
+            if (used && !out.writeAt(at, buf, used)) ok = false;
+            at += used;
+            used = 0;
+        };
+        forEachMatch(chunks[ci], [&](std::uint64_t idx) {
+            if (kBuf - used < 32 + 2 * kRecord) flush();
+            const std::uint8_t* rec = in.data() + idx * kRecord;
+            used += (std::size_t)std::snprintf(buf + used, 24, "%llu,", (unsigned long long)idx);
+            for (std::size_t i = 0; i < kRecord; ++i) {
+                buf[used++] = hex[rec[i] >> 4];
+                buf[used++] = hex[rec[i] & 15];
+            }
+            buf[used++] = '\n';
+        });
+        flush();
+    });
+    return ok;
+}
+
+bool exportColumnar(const MappedFile& in, const std::vector<ChunkResult>& chunks,
+                    const std::string& path, unsigned threads) {
+    std::vector<std::uint64_t> prefix(chunks.size());
+    std::uint64_t rows = 0;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        prefix[i] = rows;
+        rows += chunks[i].matches;
+    }
+
+    ColumnarHeader hdr{};
+    std::memcpy(hdr.magic, "PKTCOL1", 8);
+    hdr.rows       = rows;
+    hdr.recordSize = (std::uint32_t)kRecord;
+    hdr.columns    = (std::uint32_t)kRecord + 1;
+
+    const std::uint64_t idxBase = sizeof hdr;
+    const std::uint64_t colBase = idxBase + rows * sizeof(std::uint64_t);
+
+    OutFile out;
+    if (!out.create(path, colBase + rows * kRecord) || !out.writeAt(0, &hdr, sizeof hdr)) return false;
+
+    std::atomic<bool> ok{true};
+    parallelFor(chunks.size(), threads, [&](unsigned, std::size_t ci) {
+        const ChunkResult& c = chunks[ci];
+        if (!c.matches) return;
+        std::vector<std::uint64_t> idx;
+        idx.reserve(c.matches);
+        std::vector<std::uint8_t> cols(c.matches * kRecord);
+        forEachMatch(c, [&](std::uint64_t i) {
+            const std::uint8_t* rec = in.data() + i * kRecord;
+            std::size_t row = idx.size();
+            for (std::size_t j = 0; j < kRecord; ++j) cols[j * c.matches + row] = rec[j];
+            idx.push_back(i);
+        });
+        if (!out.writeAt(idxBase + prefix[ci] * sizeof(std::uint64_t), idx.data(), idx.size() * sizeof(std::uint64_t)))
+            ok = false;
+        for (std::size_t j = 0; j < kRecord && ok; ++j)
+            if (!out.writeAt(colBase + j * rows + prefix[ci], &cols[j * c.matches], c.matches))
+                ok = false;
+    });
+    return ok;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+// Pass-1 result for one 100-byte-aligned range of the capture.
+struct ChunkResult {
+    std::uint64_t              first    = 0;  // first record index in the range
+    std::uint64_t              records  = 0;
+    std::uint64_t              matches  = 0;
+    std::uint64_t              csvBytes = 0;  // exact size of this range's CSV lines
+    std::vector<std::uint64_t> bitmap;        // bit i = record first+i matched (export only)
+};
+
+// Both exporters know every range's output size up front, so all workers
+// write their slice of the output file concurrently at precomputed offsets.
+
+// CSV: "index,hex\n" per matching record, with a header line.
+bool exportCsv(const MappedFile& in, const std::vector<ChunkResult>& chunks,
+               const std::string& path, unsigned threads);
+
+// Columnar: ColumnarHeader, then u64 index[rows], then 100 columns of u8[rows]
+// (column j holds byte j of every matching record).
+bool exportColumnar(const MappedFile& in, const std::vector<ChunkResult>& chunks,
+                    const std::string& path, unsigned threads);
+
+struct ColumnarHeader {
+    char          magic[8];    // "PKTCOL1"
+    std::uint64_t rows;
+    std::uint32_t recordSize;  // 100
+    std::uint32_t columns;     // 1 index column + recordSize byte columns
+};
+
+// Length of the CSV line for record 'index' (digits + ',' + 200 hex + '\n').
+inline std::uint64_t csvLineBytes(std::uint64_t index) {
+    std::uint64_t digits = 1;
+    while (index >= 10) { index /= 10; ++digits; }
+    return digits + 1 + 200 + 1;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+constexpr std::size_t kRecord = 100; // capture files are a flat array of 100-byte packets
+
+// --match OFF:HEX — bytes at a fixed offset
+struct MatchAt {
+    std::size_t               offset = 0;
+    std::vector<std::uint8_t> bytes;
+};
+
+// --contains HEX — byte pattern anywhere in the record
+struct Contains {
+    std::vector<std::uint8_t> bytes;
+};
+
+// --range OFF:MIN:MAX (u8), --range16 / --range32 for little-endian u16/u32
+struct Range {
+    std::size_t   offset = 0;
+    unsigned      width  = 1;
+    std::uint32_t lo = 0, hi = 0;
+};
+
+// All filters must pass (logical AND). An empty set matches every record.
+struct FilterSet {
+    std::vector<MatchAt>  at;
+    std::vector<Contains> contains;
+    std::vector<Range>    ranges;
+
+    bool empty() const { return at.empty() && contains.empty() && ranges.empty(); }
+
+    bool operator()(const std::uint8_t* rec) const {
+        for (const auto& m : at)
+            if (std::memcmp(rec + m.offset, m.bytes.data(), m.bytes.size()) != 0) return false;
+        for (const auto& r : ranges) {
+            std::uint32_t v = 0;
+            std::memcpy(&v, rec + r.offset, r.width); // x86: little-endian
+            if (v < r.lo || v > r.hi) return false;
+        }
+        for (const auto& c : contains)
+            if (std::search(rec, rec + kRecord, c.bytes.begin(), c.bytes.end()) == rec + kRecord) return false;
+        return true;
+    }
+};
+
+// Per-offset aggregates over matching records.
+struct Aggregate {
+    std::uint64_t                         matches = 0;
+    std::array<std::uint8_t, kRecord>     min;
+    std::array<std::uint8_t, kRecord>     max;
+    std::array<std::uint64_t, kRecord>    sum;
+
+    Aggregate() { min.fill(0xFF); max.fill(0); sum.fill(0); }
+
+    // Plain loops over a fixed 100-byte record: the compiler vectorizes these.
+    void add(const std::uint8_t* rec) {
+        ++matches;
+        for (std::size_t i = 0; i < kRecord; ++i) {
+            min[i] = std::min(min[i], rec[i]);
+            max[i] = std::max(max[i], rec[i]);
+            sum[i] += rec[i];
+        }
+    }
+    void merge(const Aggregate& o) {
+        matches += o.matches;
+        for (std::size_t i = 0; i < kRecord; ++i) {
+            min[i] = std::min(min[i], o.min[i]);
+            max[i] = std::max(max[i], o.max[i]);
+            sum[i] += o.sum[i];
+        }
+    }
+};
+
+// ----- argument parsing -----
+
+inline bool parseHex(const std::string& s, std::vector<std::uint8_t>& out) {
+    std::string h = (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) ? s.substr(2) : s;
+    if (h.empty() || h.size() % 2) return false;
+    out.clear();
+    for (std::size_t i = 0; i < h.size(); i += 2) {
+        char* end = nullptr;
+        std::string byte = h.substr(i, 2);
+        unsigned long v = std::strtoul(byte.c_str(), &end, 16);
+        if (*end) return false;
+        out.push_back((std::uint8_t)v);
+    }
+    return true;
+}
+
+// Split "a:b:c" on ':'.
+inline std::vector<std::string> splitColon(const std::string& s) {
+    std::vector<std::string> parts;
+    std::size_t start = 0, pos;
+    while ((pos = s.find(':', start)) != std::string::npos) {
+        parts.push_back(s.substr(start, pos - start));
+        start = pos + 1;
+    }
+    parts.push_back(s.substr(start));
+    return parts;
+}
+
+inline bool parseMatch(const std::string& arg, MatchAt& m) {
+    auto p = splitColon(arg);
+    if (p.size() != 2 || !parseHex(p[1], m.bytes)) return false;
+    m.offset = std::strtoul(p[0].c_str(), nullptr, 0);
+    return m.offset + m.bytes.size() <= kRecord;
+}
+
+inline bool parseRange(const std::string& arg, unsigned width, Range& r) {
+    auto p = splitColon(arg);
+    if (p.size() != 3) return false;
+    r.offset = std::strtoul(p[0].c_str(), nullptr, 0);
+    r.width  = width;
+    r.lo     = (std::uint32_t)std::strtoul(p[1].c_str(), nullptr, 0);
+    r.hi     = (std::uint32_t)std::strtoul(p[2].c_str(), nullptr, 0);
+    return r.offset + width <= kRecord && r.lo <= r.hi;
+}
@@ -0,0 +1,44 @@
+#include "MappedFile.hpp"
+#include <cstdio>
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    // FILE_SHARE_WRITE: the receiver may still be appending to the capture.
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        std::fprintf(stderr, "[scan] open %s failed (%lu)\n", path.c_str(), GetLastError());
+        return false;
+    }
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(file_, &sz)) {
+        std::fprintf(stderr, "[scan] GetFileSizeEx failed (%lu)\n", GetLastError());
+        close();
+        return false;
+    }
+    size_ = (std::uint64_t)sz.QuadPart;
+    if (size_ == 0) return true; // nothing to map, data() stays null
+
+    map_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!map_) {
+        std::fprintf(stderr, "[scan] CreateFileMapping failed (%lu)\n", GetLastError());
+        close();
+        return false;
+    }
+    data_ = static_cast<const std::uint8_t*>(MapViewOfFile(map_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        std::fprintf(stderr, "[scan] MapViewOfFile failed (%lu)\n", GetLastError());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) { UnmapViewOfFile(data_); data_ = nullptr; }
+    if (map_)  { CloseHandle(map_); map_ = nullptr; }
+    if (file_ != INVALID_HANDLE_VALUE) { CloseHandle(file_); file_ = INVALID_HANDLE_VALUE; }
+    size_ = 0;
+}
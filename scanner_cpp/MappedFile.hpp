@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+// Read-only view of a whole file. On x64 the address space comfortably holds
+// captures of tens of GB; pages are faulted in by whichever thread touches them.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false (and prints why) if the file can't be opened or mapped.
+    bool open(const std::string& path);
+    void close();
+
+    const std::uint8_t* data() const { return data_; }
+    std::uint64_t       size() const { return size_; }
+
+private:
+    HANDLE              file_{INVALID_HANDLE_VALUE};
+    HANDLE              map_{nullptr};
+    const std::uint8_t* data_{nullptr};
+    std::uint64_t       size_{0};
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Run fn(worker, item) for item in [0, items) on 'threads' workers. Items are
+// handed out one at a time from a shared counter, so a slow range (cold pages,
+// many matches) doesn't leave the other cores idle.
+template <class Fn>
+void parallelFor(std::size_t items, unsigned threads, Fn&& fn) {
+    std::atomic<std::size_t> next{0};
+    auto worker = [&](unsigned w) {
+        for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < items;)
+            fn(w, i);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < threads; ++w) pool.emplace_back(worker, w);
+    worker(0);
+    for (auto& t : pool) t.join();
+}
@@ -0,0 +1,177 @@
+// Offline scanner for receiver capture files (flat arrays of 100-byte packets).
+//
+//   scanner.exe packets.bin [filters] [--stats] [--csv out.csv] [--columnar out.col]
+//   scanner.exe packets.bpk --packet N    (one packet from a block-compressed capture)
+//
+// The file is memory-mapped and cut into 100-byte-aligned ranges that all
+// cores pull from; each range is filtered and aggregated independently, then
+// exports write every range's slice of the output concurrently.
+#include "Export.hpp"
+#include "Filters.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+#include "BlockStore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kChunkRecords = 1u << 18; // ~26 MB per work item
+
+void usage() {
+    std::printf(
+        "Usage: scanner.exe FILE [options]\n"
+        "  --match OFF:HEX        bytes HEX at offset OFF (e.g. 0:24)\n"
+        "  --contains HEX         byte pattern anywhere in the packet\n"
+        "  --range OFF:MIN:MAX    u8 at OFF within [MIN,MAX]\n"
+        "  --range16 OFF:MIN:MAX  little-endian u16 at OFF\n"
+        "  --range32 OFF:MIN:MAX  little-endian u32 at OFF\n"
+        "  --stats                per-offset min/max/mean of matching packets\n"
+        "  --csv PATH             export matches as CSV (index,payload_hex)\n"
+        "  --columnar PATH        export matches column-wise (see Export.hpp)\n"
+        "  --threads N            worker threads (default: all cores)\n"
+        "  --packet N             print packet N (raw capture, or .bpk + .bpk.idx)\n");
+}
+
+void printPacket(std::uint64_t index, const std::uint8_t* p) {
+    std::printf("pkt#%llu", (unsigned long long)index);
+    for (std::size_t i = 0; i < kRecord; ++i) std::printf("%s%02X", i % 20 ? " " : "\n  ", p[i]);
+    std::printf("\n");
+}
+
+bool hasBlockIndex(const std::string& path) {
+    std::FILE* f = std::fopen((path + ".idx").c_str(), "rb");
+    if (!f) return false;
+    std::fclose(f);
+    return true;
+}
+
+// Random access into a block-compressed capture: only the block holding the
+// packet is read and decompressed.
+int showBlockPacket(const std::string& path, std::uint64_t index) {
+    std::uint8_t pkt[kRecord];
+    if (!readBlockPacket(path, index, pkt)) {
+        std::fprintf(stderr, "[scan] packet %llu not found in %s\n", (unsigned long long)index, path.c_str());
+        return 1;
+    }
+    printPacket(index, pkt);
+    return 0;
+}
+
+void printStats(const Aggregate& a) {
+    if (!a.matches) return;
+    std::printf("offset   min  max    mean\n");
+    for (std::size_t i = 0; i < kRecord; ++i) {
+        std::printf("%6zu  %4u %4u  %6.2f\n", i, a.min[i], a.max[i],
+                    (double)a.sum[i] / (double)a.matches);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) { usage(); return 0; }
+
+    std::string inPath = argv[1];
+    FilterSet filters;
+    bool stats = false;
+    std::string csvPath, colPath;
+    long long packet = -1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        bool hasNext = i + 1 < argc;
+        bool ok = true;
+        if (a == "--match" && hasNext)         { MatchAt m; ok = parseMatch(argv[++i], m); filters.at.push_back(m); }
+        else if (a == "--contains" && hasNext) { Contains c; ok = parseHex(argv[++i], c.bytes); filters.contains.push_back(c); }
+        else if (a == "--range" && hasNext)    { Range r; ok = parseRange(argv[++i], 1, r); filters.ranges.push_back(r); }
+        else if (a == "--range16" && hasNext)  { Range r; ok = parseRange(argv[++i], 2, r); filters.ranges.push_back(r); }
+        else if (a == "--range32" && hasNext)  { Range r; ok = parseRange(argv[++i], 4, r); filters.ranges.push_back(r); }
+        else if (a == "--stats")               { stats = true; }
+        else if (a == "--csv" && hasNext)      { csvPath = argv[++i]; }
+        else if (a == "--columnar" && hasNext) { colPath = argv[++i]; }
+        else if (a == "--threads" && hasNext)  { threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10)); }
+        else if (a == "--packet" && hasNext)   { packet = std::strtoll(argv[++i], nullptr, 10); }
+        else { usage(); return 1; }
+        if (!ok) { std::fprintf(stderr, "[scan] bad value for %s\n", a.c_str()); return 1; }
+    }
+
+    if (packet >= 0 && hasBlockIndex(inPath))
+        return showBlockPacket(inPath, (std::uint64_t)packet);
+
+    MappedFile in;
+    if (!in.open(inPath)) return 1;
+    const std::uint64_t records = in.size() / kRecord;
+    if (packet >= 0) {
+        if ((std::uint64_t)packet >= records) { std::fprintf(stderr, "[scan] no packet %lld\n", packet); return 1; }
+        printPacket((std::uint64_t)packet, in.data() + (std::uint64_t)packet * kRecord);
+        return 0;
+    }
+    if (in.size() % kRecord) {
+        std::fprintf(stderr, "[scan] ignoring %llu trailing bytes (partial packet)\n",
+                     (unsigned long long)(in.size() % kRecord));
+    }
+
+    const bool exporting = !csvPath.empty() || !colPath.empty();
+    std::vector<ChunkResult> chunks((std::size_t)((records + kChunkRecords - 1) / kChunkRecords));
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        chunks[i].first   = i * kChunkRecords;
+        chunks[i].records = std::min(kChunkRecords, records - chunks[i].first);
+        if (exporting) chunks[i].bitmap.assign((std::size_t)((chunks[i].records + 63) / 64), 0);
+    }
+
+    // ----- pass 1: filter + aggregate, one worker-local Aggregate each -----
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Aggregate> perWorker(threads);
+    const bool matchAll = filters.empty();
+
+    parallelFor(chunks.size(), threads, [&](unsigned w, std::size_t ci) {
+        ChunkResult& c = chunks[ci];
+        Aggregate& agg = perWorker[w];
+        const std::uint8_t* rec = in.data() + c.first * kRecord;
+        for (std::uint64_t i = 0; i < c.records; ++i, rec += kRecord) {
+            if (!matchAll && !filters(rec)) continue;
+            ++c.matches;
+            if (stats) agg.add(rec);
+            if (exporting) {
+                c.bitmap[(std::size_t)(i / 64)] |= 1ull << (i % 64);
+                c.csvBytes += csvLineBytes(c.first + i);
+            }
+        }
+    });
+
+    Aggregate total;
+    for (const auto& a : perWorker) total.merge(a);
+    std::uint64_t matches = 0;
+    for (const auto& c : chunks) matches += c.matches;
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("[scan] %llu packets, %llu match, %.2fs, %.2f GB/s on %u threads\n",
+                (unsigned long long)records, (unsigned long long)matches, secs,
+                secs > 0 ? (double)in.size() / secs / 1e9 : 0.0, threads);
+    if (stats) printStats(total);
+
+    // ----- pass 2: exports -----
+    bool ok = true;
+    if (!csvPath.empty()) {
+        auto t1 = std::chrono::steady_clock::now();
+        ok = exportCsv(in, chunks, csvPath, threads) && ok;
+        std::printf("[export] csv %s in %.2fs\n", csvPath.c_str(),
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count());
+    }
+    if (!colPath.empty()) {
+        auto t1 = std::chrono::steady_clock::now();
+        ok = exportColumnar(in, chunks, colPath, threads) && ok;
+        std::printf("[export] columnar %s in %.2fs\n", colPath.c_str(),
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count());
+    }
+    return ok ? 0 : 1;
+}
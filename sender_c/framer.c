@@ -0,0 +1,86 @@
+#include "framer.h"
+#include <stdbool.h>
+#include <intrin.h>
+#include <immintrin.h>
+
+static __forceinline unsigned lowest_bit(unsigned mask){
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (unsigned)idx;
+}
+
+static const uint8_t* find_scalar(const uint8_t* p, const uint8_t* end, uint8_t b){
+    for (; p < end; ++p) if (*p == b) return p;
+    return NULL;
+}
+
+static const uint8_t* find_sse2(const uint8_t* p, const uint8_t* end, uint8_t b){
+    const __m128i needle = _mm_set1_epi8((char)b);
+    for (; end - p >= 16; p += 16) {
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), needle));
+        if (m) return p + lowest_bit(m);
+    }
+    return find_scalar(p, end, b);
+}
+
+// Only called after the runtime AVX2 check in detect_avx2().
+static const uint8_t* find_avx2(const uint8_t* p, const uint8_t* end, uint8_t b){
+    const __m256i needle = _mm256_set1_epi8((char)b);
+    for (; end - p >= 64; p += 64) {
+        unsigned ma = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), needle));
+        unsigned mc = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), needle));
+        if (ma) return p + lowest_bit(ma);
+        if (mc) return p + 32 + lowest_bit(mc);
+    }
+    return find_sse2(p, end, b);
+}
+
+static int s_avx2 = -1; // -1 = not probed yet
+
+static bool detect_avx2(void){
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+    __cpuid(r, 1);
+    if (!(r[2] & (1 << 27)) || !(r[2] & (1 << 28))) return false; // OSXSAVE + AVX
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;                   // OS saves YMM state
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+}
+
+const uint8_t* framer_find(const uint8_t* p, const uint8_t* end, uint8_t b){
+    if (p < end && *p == b) return p; // aligned steady state
+    if (s_avx2 < 0) s_avx2 = detect_avx2() ? 1 : 0;
+    return s_avx2 ? find_avx2(p, end, b) : find_sse2(p, end, b);
+}
+
+const char* framer_kernel_name(void){
+    if (s_avx2 < 0) s_avx2 = detect_avx2() ? 1 : 0;
+    return s_avx2 ? "avx2" : "sse2";
+}
+
+void framer_init(Framer* f, uint8_t start, uint8_t end, size_t frame_len){
+    f->start = start;
+    f->end = end;
+    f->frame_len = frame_len;
+    f->frames = f->malformed = f->junk = 0;
+}
+
+size_t framer_scan(Framer* f, const uint8_t* buf, size_t n, FrameSink sink, void* ctx){
+    size_t i = 0;
+    for (;;) {
+        const uint8_t* s = framer_find(buf + i, buf + n, f->start);
+        if (!s) { f->junk += n - i; return n; }
+        f->junk += (size_t)(s - (buf + i));
+        i = (size_t)(s - buf);
+        if (n - i < f->frame_len) return i;           // partial frame
+        if (buf[i + f->frame_len - 1] == f->end) {
+            sink(ctx, buf + i);
+            ++f->frames;
+            i += f->frame_len;
+        } else {
+            ++f->malformed;                            // resync on next start byte
+            ++i;
+        }
+    }
+}
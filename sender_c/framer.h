@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Delimiter-based framing: a frame is 'start' + payload + 'end', frame_len
+// bytes in total. Bytes that don't form a valid frame are skipped up to the
+// next start byte, so a dropped serial byte costs one frame, not the session.
+typedef struct {
+    uint8_t  start;
+    uint8_t  end;
+    size_t   frame_len;
+    uint64_t frames;      // valid frames found
+    uint64_t malformed;   // start byte without a matching end byte
+    uint64_t junk;        // bytes skipped while looking for a start byte
+} Framer;
+
+typedef void (*FrameSink)(void* ctx, const uint8_t* frame);
+
+void framer_init(Framer* f, uint8_t start, uint8_t end, size_t frame_len);
+
+// Scan buf[0..n), calling sink(ctx, frame) for each valid frame (pointer into
+// buf). Returns bytes consumed; keep buf[consumed..n) (< frame_len bytes) and
+// prepend it to the next chunk.
+size_t framer_scan(Framer* f, const uint8_t* buf, size_t n, FrameSink sink, void* ctx);
+
+// First 'b' in [p, end) or NULL. AVX2 when available, SSE2 otherwise.
+const uint8_t* framer_find(const uint8_t* p, const uint8_t* end, uint8_t b);
+const char* framer_kernel_name(void);
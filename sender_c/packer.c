@@ -1,24 +1,337 @@
 #include "packer.h"
 #include <process.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 extern volatile LONG g_running; // declared in sender.c
 
+#define PACK_STAGE_BYTES (64*1024)                         // bytes pulled from the ring per scan
+#define PACK_OUT_FRAMES  (PACK_STAGE_BYTES / FRAME_SIZE)   // frames per send batch
+#define PACK_OUT_BYTES   (PACK_OUT_FRAMES * FRAME_SIZE)
+#define CONNECT_TIMEOUT_MS 500
+#define RECONNECT_MIN_MS   5      // first retry is immediate, then 5, 10, 20 ... ms
+#define RECONNECT_MS       1000   // backoff cap
+#define RESUME_FINISH_MS   30000  // resume mode at exit: keep reconnecting for the last acks this long
+
+// The TCP side. At most one batch is in flight and it is sent without
+// blocking, so the packer keeps draining the ring while the receiver is slow.
+typedef struct {
+    SOCKET   sock;       // INVALID_SOCKET while the link is down
+    DWORD    retry_at;   // GetTickCount() of the next connect attempt
+    DWORD    backoff;    // delay before the attempt after that
+    uint8_t* buf;        // batch being sent
+    size_t   len, off;
+    unsigned connects;
+} Link;
+
+typedef struct {
+    PackerArgs* pa;
+    Link        link;
+    size_t      frame_len;        // bytes taken per frame (rest zero-padded)
+    uint8_t*    out;              // live frames not yet handed to the link
+    size_t      count;
+    bool        spool_turn_done;  // interleave: last batch came from the spool
+    uint64_t    sent_live;        // frames sent without touching the spool
+    uint64_t    sent_spool;       // frames sent from the spool
+} Packer;
+
+static bool link_up(const Packer* pk)   { return pk->link.sock != INVALID_SOCKET; }
+static bool link_idle(const Packer* pk) {
+    return pk->pa->resume ? !rw_unsent(pk->pa->resume) : pk->link.off == pk->link.len;
+}
+// Resume mode: window full of unacknowledged frames, nothing can go out until an ack.
+static bool link_blocked(const Packer* pk) {
+    return pk->pa->resume && link_up(pk) && !rw_room(pk->pa->resume);
+}
+
+static bool ring_over(const Packer* pk) {
+    return rb_size(pk->pa->rb) * 100 > (size_t)pk->pa->high_pct * pk->pa->rb->cap;
+}
+
+static void retry_later(Link* lk) {
+    lk->retry_at = GetTickCount() + lk->backoff;
+    lk->backoff = lk->backoff < RECONNECT_MIN_MS ? RECONNECT_MIN_MS
+                : lk->backoff * 2 > RECONNECT_MS ? RECONNECT_MS : lk->backoff * 2;
+}
+
+// Connection lost: whole frames not yet sent go back to the front of the spool,
+// so they are resent first and in order (a frame cut in half is resent in full). In resume mode they stay
+// in the window, and the socket is reset so the receiver doesn't take the close
+// for the end of the session.
+static void link_down(Packer* pk) {
+    Link* lk = &pk->link;
+    if (pk->pa->resume) {
+        struct linger lg = { 1, 0 };
+        setsockopt(lk->sock, SOL_SOCKET, SO_LINGER, (const char*)&lg, sizeof lg);
+    } else {
+        size_t first = lk->off / FRAME_SIZE;
+        size_t n = lk->len / FRAME_SIZE - first;
+        if (n) spool_unread(pk->pa->spool, lk->buf + first * FRAME_SIZE, n);
+    }
+    closesocket(lk->sock);
+    lk->sock = INVALID_SOCKET;
+    lk->len = lk->off = 0;
+    retry_later(lk);
+    fprintf(stderr, pk->pa->resume ? "[packer] link down, reconnecting\n" : "[packer] link down, spooling\n");
+}
+
+static void link_maintain(Packer* pk) {
+    Link* lk = &pk->link;
+    if (pk->pa->udp || pk->pa->stripes || link_up(pk) || (LONG)(GetTickCount() - lk->retry_at) < 0) return;
+    lk->sock = tcp_connect_timeout(pk->pa->host, pk->pa->port, CONNECT_TIMEOUT_MS);
+    if (lk->sock == INVALID_SOCKET) { retry_later(lk); return; }
+    ResumeWindow* rw = pk->pa->resume;
+    if (rw && !rw_hello(rw, lk->sock, CONNECT_TIMEOUT_MS)) {
+        fprintf(stderr, "[packer] no resume reply from %s:%u\n", pk->pa->host, (unsigned)pk->pa->port);
+        closesocket(lk->sock);
+        lk->sock = INVALID_SOCKET;
+        retry_later(lk);
+        return;
+    }
+    lk->backoff = 0;
+    ++lk->connects;
+    if (rw && rw->hellos > 1) {
+        printf("[packer] reconnected, resuming at frame %llu (%llu unacknowledged)\n",
+               (unsigned long long)rw->acked, (unsigned long long)(rw->queued - rw->acked));
+        return;
+    }
+    printf("[packer] connected to %s:%u, %llu frames spooled\n", pk->pa->host, (unsigned)pk->pa->port,
+           (unsigned long long)spool_frames(pk->pa->spool));
+}
+
+static void link_pump(Packer* pk, DWORD timeout_ms) {
+    Link* lk = &pk->link;
+    if (pk->pa->resume) {   // also reads acks, so it runs while the link is idle too
+        if (link_up(pk) && !rw_pump(pk->pa->resume, lk->sock, timeout_ms)) link_down(pk);
+        return;
+    }
+    if (!link_up(pk) || link_idle(pk)) return;
+    int n = tcp_send_some(lk->sock, lk->buf + lk->off, lk->len - lk->off, timeout_ms);
+    if (n < 0) { link_down(pk); return; }
+    lk->off += (size_t)n;
+    if (lk->off == lk->len) lk->len = lk->off = 0;
+}
+
+// Resume mode: the batch is copied into the window (as much as fits) and sent from there.
+static void feed_window(Packer* pk, bool take_live, bool spooled) {
+    ResumeWindow* rw = pk->pa->resume;
+    size_t room = rw_room(rw);
+    if (take_live) {
+        size_t n = pk->count < room ? pk->count : room;
+        rw_push(rw, pk->out, n);
+        memmove(pk->out, pk->out + n * FRAME_SIZE, (pk->count - n) * FRAME_SIZE);
+        pk->count -= n;
+        pk->sent_live += n;
+        pk->spool_turn_done = false;
+    } else if (spooled) {
+        size_t n = spool_take(pk->pa->spool, pk->link.buf, room < PACK_OUT_FRAMES ? room : PACK_OUT_FRAMES);
+        rw_push(rw, pk->link.buf, n);
+        pk->sent_spool += n;
+        pk->spool_turn_done = true;
+    }
+    link_pump(pk, 0);
+}
+
+// When the link is idle, pick the next batch: spool or live, per policy.
+// Live frames win under INTERLEAVE while the ring is filling up.
+static void feed_link(Packer* pk, bool over) {
+    Link* lk = &pk->link;
+    if (!link_up(pk) || !link_idle(pk) || link_blocked(pk)) return;
+    bool spooled = !spool_empty(pk->pa->spool);
+    bool take_live;
+    if (!spooled)                                take_live = pk->count > 0;
+    else if (pk->pa->policy == SPOOL_BEHIND)     take_live = false;
+    else                                         take_live = pk->count > 0 && (over || pk->spool_turn_done);
+    if (pk->pa->resume) { feed_window(pk, take_live, spooled); return; }
+
+    if (take_live) {
+        uint8_t* t = lk->buf; lk->buf = pk->out; pk->out = t;   // hand over without copying
+        lk->len = pk->count * FRAME_SIZE;
+        pk->sent_live += pk->count;
+        pk->count = 0;
+        pk->spool_turn_done = false;
+    } else if (spooled) {
+        size_t n = spool_take(pk->pa->spool, lk->buf, PACK_OUT_FRAMES);
+        lk->len = n * FRAME_SIZE;
+        pk->sent_spool += n;
+        pk->spool_turn_done = true;
+    }
+    lk->off = 0;
+    link_pump(pk, 0);
+}
+
+// Live frames that can't go out now are spooled, unless the link will be idle
+// soon and the ring has room to wait.
+static void spill(Packer* pk, bool force) {
+    if (!pk->count || pk->pa->udp || pk->pa->stripes) return;
+    if (force || !link_up(pk) || ring_over(pk) ||
+        (pk->pa->policy == SPOOL_BEHIND && !spool_empty(pk->pa->spool))) {
+        spool_append(pk->pa->spool, pk->out, pk->count);
+        pk->count = 0;
+    }
+}
+
+// UDP: no connection to wait for and nothing to spool; loss is the receiver's to count.
+static void send_udp(Packer* pk) {
+    if (!pk->count) return;
+    udp_send_frames(pk->pa->udp, pk->out, pk->count);
+    pk->sent_live += pk->count;
+    pk->count = 0;
+}
+
+// Striped: wait for queue space on the connections that keep up. Frames are
+// dropped only once every connection has failed.
+static void send_striped(Packer* pk) {
+    StripeSet* ss = pk->pa->stripes;
+    size_t done = 0;
+    while (done < pk->count && stripe_alive(ss)) {
+        done += stripe_send(ss, pk->out + done * FRAME_SIZE, pk->count - done);
+        stripe_pump(ss, done < pk->count ? 5 : 0);
+    }
+    pk->sent_live += done;
+    if (done < pk->count)
+        fprintf(stderr, "[packer] all stripes down, dropped %zu frames\n", pk->count - done);
+    pk->count = 0;
+}
+
+// Resume mode at exit: keep sending, and reconnecting, until every frame is
+// acknowledged, then end the session with a graceful close. Only if that
+// doesn't happen within RESUME_FINISH_MS is the session left open (reset) and
+// the rest put back at the front of the spool for the next run, where the
+// receiver may see some twice.
+static void finish_window(Packer* pk) {
+    ResumeWindow* rw = pk->pa->resume;
+    DWORD start = GetTickCount();
+    while (rw->acked < rw->queued && GetTickCount() - start < RESUME_FINISH_MS) {
+        link_maintain(pk);
+        if (link_up(pk)) link_pump(pk, 10);
+        else             Sleep(5);
+    }
+    if (rw->acked < rw->queued) {
+        if (link_up(pk)) {   // reset: a graceful close would end the session
+            struct linger lg = { 1, 0 };
+            setsockopt(pk->link.sock, SOL_SOCKET, SO_LINGER, (const char*)&lg, sizeof lg);
+            closesocket(pk->link.sock);
+            pk->link.sock = INVALID_SOCKET;
+        }
+        fprintf(stderr, "[packer] resume: %llu frames still unacknowledged after %u ms, spooling them\n",
+                (unsigned long long)(rw->queued - rw->acked), (unsigned)RESUME_FINISH_MS);
+        // In front of what is spooled already: those frames came after the window.
+        // The window is a ring, so that is at most two pieces, newer one first.
+        size_t n = (size_t)(rw->queued - rw->acked);
+        size_t first = rw->cap - (size_t)(rw->acked % rw->cap);
+        if (first > n) first = n;
+        if (n > first) spool_unread(pk->pa->spool, rw->buf, n - first);
+        spool_unread(pk->pa->spool, rw_frame(rw, rw->acked), first);
+    } else if (link_up(pk)) {
+        shutdown(pk->link.sock, SD_SEND);
+        closesocket(pk->link.sock);
+        pk->link.sock = INVALID_SOCKET;
+    }
+    printf("[packer] resume: %llu sessions resumed, %llu frames resent, %llu unacknowledged at exit\n",
+           (unsigned long long)rw->resumes, (unsigned long long)rw->resent,
+           (unsigned long long)(rw->queued - rw->acked));
+}
+
+// Frame sink: frames shorter than FRAME_SIZE are zero-padded so the wire
+// format stays fixed 100-byte records.
+static void add_frame(void* ctx, const uint8_t* frame) {
+    Packer* pk = (Packer*)ctx;
+    uint8_t* dst = pk->out + pk->count * FRAME_SIZE;
+    memcpy(dst, frame, pk->frame_len);
+    if (pk->frame_len < FRAME_SIZE) memset(dst + pk->frame_len, 0, FRAME_SIZE - pk->frame_len);
+    if (++pk->count == PACK_OUT_FRAMES) {
+        if (pk->pa->udp)     { send_udp(pk); return; }
+        if (pk->pa->stripes) { send_striped(pk); return; }
+        feed_link(pk, true);
+        if (pk->count == PACK_OUT_FRAMES) spill(pk, true);
+    }
+}
+
+static size_t cut_fixed(Packer* pk, const uint8_t* buf, size_t n) {
+    size_t i = 0;
+    for (; n - i >= FRAME_SIZE; i += FRAME_SIZE) add_frame(pk, buf + i);
+    return i;
+}
+
 unsigned __stdcall packer_thread(void* arg) {
     PackerArgs* pa = (PackerArgs*)arg;
-    uint8_t frame[FRAME_SIZE];
-    unsigned count = 0;
-
-    printf("[packer] started\n");
-    while (InterlockedCompareExchange(&g_running, 1, 1) == 1) {
-        rb_pop_exact(pa->rb, frame, FRAME_SIZE); // blocks until 100 ready
-        if (!tcp_send_all(pa->sock, frame, FRAME_SIZE)) {
-            fprintf(stderr, "[packer] send failed\n");
-            break;
+    Framer* fr = pa->framer;
+    Packer pk;
+    memset(&pk, 0, sizeof pk);
+    pk.pa = pa;
+    pk.link.sock = INVALID_SOCKET;
+    pk.link.retry_at = GetTickCount();
+    pk.frame_len = fr ? fr->frame_len : FRAME_SIZE;
+    pk.out = (uint8_t*)malloc(PACK_OUT_BYTES);
+    pk.link.buf = (uint8_t*)malloc(PACK_OUT_BYTES);
+    uint8_t* stage = (uint8_t*)malloc(PACK_STAGE_BYTES + FRAME_SIZE);
+    size_t fill = 0;
+
+    if (!stage || !pk.out || !pk.link.buf) {
+        fprintf(stderr, "[packer] out of memory\n");
+        free(stage); free(pk.out); free(pk.link.buf);
+        return 0;
+    }
+    printf("[packer] started (%s framing, spool policy %s)\n",
+           fr ? framer_kernel_name() : "fixed", pa->policy == SPOOL_BEHIND ? "behind" : "interleave");
+
+    for (;;) {
+        link_maintain(&pk);
+        link_pump(&pk, 0);
+
+        // Don't sleep on the ring while there is spool or in-flight data to push.
+        bool busy = link_up(&pk) && (!link_idle(&pk) || !spool_empty(pa->spool) || pk.count);
+        if (pa->stripes) {
+            stripe_pump(pa->stripes, 0);
+            busy = !stripe_idle(pa->stripes) && stripe_alive(pa->stripes);
         }
-        if ((++count % 500) == 0) printf("[packer] sent %u frames\n", count);
+        size_t n = rb_pop_wait(pa->rb, stage + fill, PACK_STAGE_BYTES + FRAME_SIZE - fill, busy ? 0 : 50);
+        if (!n && rb_drained(pa->rb)) break;
+        if (n) {
+            fill += n;
+            size_t used = fr ? framer_scan(fr, stage, fill, add_frame, &pk) : cut_fixed(&pk, stage, fill);
+            memmove(stage, stage + used, fill - used);
+            fill -= used;
+        }
+
+        if (pa->udp)     { send_udp(&pk); continue; }
+        if (pa->stripes) {
+            send_striped(&pk);
+            if (!n && busy) stripe_pump(pa->stripes, 5);   // nothing new: wait for socket space
+            continue;
+        }
+        feed_link(&pk, ring_over(&pk));
+        spill(&pk, false);
+        if (!n && (!link_idle(&pk) || link_blocked(&pk))) link_pump(&pk, 5);   // nothing new: wait for socket space / acks
     }
+
+    if (pa->udp) {
+        send_udp(&pk);
+        udp_send_end(pa->udp);
+    }
+    if (pa->stripes) send_striped(&pk);   // stripe_close() in main flushes the queues
+    // Finish the batch in flight; anything else is kept in the spool for the next run.
+    if (pa->resume) finish_window(&pk);
+    else if (link_up(&pk)) {
+        link_pump(&pk, 1000);
+        if (!link_idle(&pk)) link_down(&pk);
+        else                 closesocket(pk.link.sock);
+    }
+    spill(&pk, true);
+
+    printf("[packer] sent %llu live + %llu spooled frames, %u connects; spool: %llu in, %llu dropped, %llu still queued\n",
+           (unsigned long long)pk.sent_live, (unsigned long long)pk.sent_spool, pk.link.connects,
+           (unsigned long long)pa->spool->spooled, (unsigned long long)pa->spool->dropped,
+           (unsigned long long)spool_frames(pa->spool));
+    if (fr)
+        printf("[packer] malformed %llu, skipped bytes %llu\n",
+               (unsigned long long)fr->malformed, (unsigned long long)fr->junk);
+    free(stage);
+    free(pk.out);
+    free(pk.link.buf);
     printf("[packer] exiting\n");
     return 0;
 }
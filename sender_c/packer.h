@@ -4,14 +4,36 @@
 #include <stdint.h>
 #include "ring_buffer.h"
 #include "tcp.h"
+#include "framer.h"
+#include "spool.h"
+#include "stripe.h"
+#include "resume.h"
 
 #define FRAME_SIZE 100
 
-// Thread function: pops 100B frames from ring and sends them over 'sock'.
-unsigned __stdcall packer_thread(void* sock_and_rb);
+// Where live frames go while the spool still holds older ones.
+typedef enum {
+    SPOOL_BEHIND = 0,     // strict order: live frames queue behind the spool until it's empty
+    SPOOL_INTERLEAVE      // alternate spool and live batches (fresh data isn't held back)
+} SpoolPolicy;
+
+// Thread function: pops frames from the ring and sends them to host:port,
+// (re)connecting as needed. Frames the link can't take go to the spool.
+// In UDP mode every batch goes straight out as datagrams; in striped mode it
+// is spread over the StripeSet's connections. With a ResumeWindow, frames stay
+// in it until the receiver acknowledges them and a reconnect resumes the session.
+unsigned __stdcall packer_thread(void* args);
 
 // Helper to pack args for the thread
 typedef struct {
-    SOCKET    sock;
-    ByteRing* rb;
+    const char*    host;
+    unsigned short port;
+    ByteRing*      rb;
+    Framer*        framer;    // NULL = blind FRAME_SIZE chunks; else delimiter framing
+    Spool*         spool;
+    SpoolPolicy    policy;
+    unsigned       high_pct;  // ring fill (%) above which live frames are spooled right away
+    UdpLink*       udp;       // non-NULL: send datagrams here instead of the TCP link (no spooling)
+    StripeSet*     stripes;   // non-NULL: stripe frames over these connections (no spooling)
+    ResumeWindow*  resume;    // non-NULL: session resume, unacknowledged frames are kept here
 } PackerArgs;
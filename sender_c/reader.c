@@ -14,7 +14,8 @@ static unsigned __stdcall reader_thread(void* arg) {
     return 0;
 }
 
-bool reader_start(Reader* r, const ReaderConfig* cfg, ByteRing* rb, volatile LONG* running) {
+bool reader_start(Reader* r, const ReaderConfig* cfg, ByteRing* rb, volatile LONG* running,
+                  const ThreadPlacement* tp) {
     ZeroMemory(r, sizeof *r);
     r->rb = rb;
     r->running = running;
@@ -22,12 +23,14 @@ bool reader_start(Reader* r, const ReaderConfig* cfg, ByteRing* rb, volatile LON
     if (!serial_open(&r->serial, cfg)) {
         return false;
     }
-    r->thread = (HANDLE)_beginthreadex(NULL, 0, reader_thread, r, 0, NULL);
+    r->thread = (HANDLE)_beginthreadex(NULL, 0, reader_thread, r, CREATE_SUSPENDED, NULL);
     if (!r->thread) {
         fprintf(stderr, "[reader] failed to start thread\n");
         serial_close(&r->serial);
         return false;
     }
+    thread_place_apply(r->thread, tp);
+    ResumeThread(r->thread);
     return true;
 }
 
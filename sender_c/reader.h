@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include "serial.h"
 #include "ring_buffer.h"
+#include "thread_place.h"
 
 // Opaque-ish reader that owns the serial ctx + thread
 typedef struct {
@@ -13,8 +14,10 @@ typedef struct {
 } Reader;
 
 // Start the reader thread. If cfg->use_serial == false, uses emulator.
+// 'tp' (optional) is applied before the thread runs its first instruction.
 // Returns false on failure (e.g., cannot open COM).
-bool reader_start(Reader* r, const ReaderConfig* cfg, ByteRing* rb, volatile LONG* running);
+bool reader_start(Reader* r, const ReaderConfig* cfg, ByteRing* rb, volatile LONG* running,
+                  const ThreadPlacement* tp);
 
 // Join/close. Safe to call even if reader_start failed partially.
 void reader_join(Reader* r);
@@ -0,0 +1,111 @@
+#include "resume.h"
+#include "tcp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool rw_init(ResumeWindow* rw, size_t frames, size_t frame_size) {
+    memset(rw, 0, sizeof *rw);
+    rw->cap = frames ? frames : 1;
+    rw->frame_size = frame_size;
+    rw->buf = (uint8_t*)malloc(rw->cap * frame_size);
+    if (!rw->buf) { fprintf(stderr, "[resume] out of memory\n"); return false; }
+    // Unique per run, so a restarted sender isn't taken for the old session.
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    rw->session = ((uint64_t)GetCurrentProcessId() << 40) ^ (uint64_t)t.QuadPart;
+    return true;
+}
+
+void rw_free(ResumeWindow* rw) {
+    free(rw->buf);
+    rw->buf = NULL;
+}
+
+void rw_push(ResumeWindow* rw, const uint8_t* frames, size_t n) {
+    while (n) {
+        size_t at = (size_t)(rw->queued % rw->cap);
+        size_t k = rw->cap - at < n ? rw->cap - at : n;
+        memcpy(rw->buf + at * rw->frame_size, frames, k * rw->frame_size);
+        frames += k * rw->frame_size;
+        rw->queued += k;
+        n -= k;
+    }
+}
+
+// Receiver count -> our numbering. Never past what was queued, never backwards.
+static void on_count(ResumeWindow* rw, uint64_t count) {
+    uint64_t have = rw->base + count;
+    if (have > rw->queued) have = rw->queued;
+    if (have > rw->acked) {
+        rw->acked = have;
+        rw->ack_at = GetTickCount();
+    }
+}
+
+bool rw_hello(ResumeWindow* rw, SOCKET s, DWORD timeout_ms) {
+    uint8_t h[16];
+    uint32_t magic = RESUME_MAGIC, flags = 0;
+    memcpy(h, &magic, 4);
+    memcpy(h + 4, &flags, 4);
+    memcpy(h + 8, &rw->session, 8);
+    if (tcp_send_some(s, h, sizeof h, timeout_ms) != (int)sizeof h) return false;
+
+    size_t got = 0;
+    DWORD start = GetTickCount();
+    while (got < sizeof h) {
+        DWORD waited = GetTickCount() - start;
+        if (waited >= timeout_ms) return false;
+        int n = tcp_recv_some(s, h + got, sizeof h - got, timeout_ms - waited);
+        if (n < 0) return false;
+        got += (size_t)n;
+    }
+    uint64_t count;
+    memcpy(&magic, h, 4);
+    memcpy(&flags, h + 4, 4);
+    memcpy(&count, h + 8, 8);
+    if (magic != RESUME_MAGIC) return false;
+
+    // A receiver that doesn't know us (restarted) gets everything not acknowledged.
+    if (flags & RESUME_NEW) rw->base = rw->acked;
+    else                    on_count(rw, count);
+    if (++rw->hellos > 1 && !(flags & RESUME_NEW)) ++rw->resumes;
+
+    uint64_t sent_frames = (rw->sent + rw->frame_size - 1) / rw->frame_size;
+    if (sent_frames > rw->acked) rw->resent += sent_frames - rw->acked;
+    rw->sent = rw->acked * rw->frame_size;
+    rw->ack_fill = 0;
+    rw->ack_at = GetTickCount();
+    return true;
+}
+
+bool rw_pump(ResumeWindow* rw, SOCKET s, DWORD timeout_ms) {
+    const uint64_t ring = (uint64_t)rw->cap * rw->frame_size;
+    if (rw->acked * rw->frame_size >= rw->sent) rw->ack_at = GetTickCount();   // nothing outstanding yet
+    // At most two pieces: up to the end of the ring, then from its start.
+    for (int i = 0; i < 2 && rw_unsent(rw); ++i) {
+        size_t at = (size_t)(rw->sent % ring);
+        uint64_t left = rw->queued * rw->frame_size - rw->sent;
+        size_t len = (size_t)(left < ring - at ? left : ring - at);
+        int n = tcp_send_some(s, rw->buf + at, len, timeout_ms);
+        if (n < 0) return false;
+        rw->sent += (size_t)n;
+        if ((size_t)n < len) break;
+    }
+
+    DWORD wait = !rw_unsent(rw) && rw->acked < rw->queued ? timeout_ms : 0;
+    for (;;) {
+        int n = tcp_recv_some(s, rw->ack + rw->ack_fill, sizeof rw->ack - rw->ack_fill, wait);
+        if (n < 0) return false;
+        if (n == 0) break;
+        wait = 0;
+        rw->ack_fill += (size_t)n;
+        if (rw->ack_fill == sizeof rw->ack) {
+            uint64_t count;
+            memcpy(&count, rw->ack, 8);
+            on_count(rw, count);
+            rw->ack_fill = 0;
+        }
+    }
+    return rw->acked * rw->frame_size >= rw->sent || GetTickCount() - rw->ack_at < RESUME_ACK_TIMEOUT_MS;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <winsock2.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Session resume (receiver --resume). Every connection opens with a hello
+// {u32 'RSM1', u32 0, u64 session}. The receiver answers {u32 'RSM1', u32 flags,
+// u64 frames of this session it already has} and then acknowledges with that
+// u64 count as frames arrive.
+//
+// Frames handed to the link stay in a window until they are acknowledged.
+// After a dropped connection the packer reconnects and sends again from the
+// frame the receiver reports, so nothing that was in flight is lost.
+#define RESUME_MAGIC 0x314D5352u   // "RSM1"
+#define RESUME_NEW   1u            // reply flag: receiver doesn't know the session, counts from 0
+#define RESUME_ACK_TIMEOUT_MS 3000 // unacknowledged data and no ack for this long: link is dead
+
+typedef struct {
+    uint8_t* buf;           // ring of frames [acked, queued)
+    size_t   cap;           // in frames
+    size_t   frame_size;
+    uint64_t session;
+    uint64_t queued;        // frames put in the window so far
+    uint64_t acked;         // frames the receiver has
+    uint64_t sent;          // bytes of the stream handed to send()
+    uint64_t base;          // our frame number the receiver counts as its 0
+    uint8_t  ack[8];        // ack being received
+    size_t   ack_fill;
+    DWORD    ack_at;        // GetTickCount() of the last ack progress
+    unsigned hellos;
+    uint64_t resumes, resent;
+} ResumeWindow;
+
+bool rw_init(ResumeWindow* rw, size_t frames, size_t frame_size);
+void rw_free(ResumeWindow* rw);
+
+static inline size_t rw_room(const ResumeWindow* rw) { return rw->cap - (size_t)(rw->queued - rw->acked); }
+static inline bool rw_unsent(const ResumeWindow* rw) { return rw->sent < rw->queued * rw->frame_size; }
+static inline const uint8_t* rw_frame(const ResumeWindow* rw, uint64_t i) {
+    return rw->buf + (size_t)(i % rw->cap) * rw->frame_size;   // i in [acked, queued)
+}
+
+// Copy n frames (n <= rw_room()) into the window; rw_pump() sends them.
+void rw_push(ResumeWindow* rw, const uint8_t* frames, size_t n);
+
+// Hello on a freshly connected non-blocking socket. Rewinds to the first frame
+// the receiver doesn't have. false: no valid reply within timeout_ms.
+bool rw_hello(ResumeWindow* rw, SOCKET s, DWORD timeout_ms);
+
+// Send what is unsent and read acks. When everything is sent but not yet
+// acknowledged, waits up to timeout_ms for an ack. false: the connection failed.
+bool rw_pump(ResumeWindow* rw, SOCKET s, DWORD timeout_ms);
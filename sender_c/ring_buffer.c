@@ -4,13 +4,66 @@
 
 static __forceinline size_t minz(size_t a, size_t b){ return a < b ? a : b; }
 
+static LONGLONG qpc_now(void){ LARGE_INTEGER t; QueryPerformanceCounter(&t); return t.QuadPart; }
+
+// Poll 'what' (read without the lock) until it changes, the ring closes or the
+// spin budget runs out. Spinning happens outside cs so the other side is never
+// blocked by us; the caller re-checks under the lock afterwards.
+// 'bounded' caps RB_WAIT_SPIN at spin_limit too (for waits with a timeout).
+static void spin_while_equal(ByteRing* rb, const volatile size_t* what, size_t value, RbWaitStats* st, bool bounded){
+    if(rb->wait_mode == RB_WAIT_BLOCK) return;
+    uint64_t limit = (rb->wait_mode == RB_WAIT_SPIN && !bounded) ? UINT64_MAX : rb->spin_limit;
+    uint64_t n = 0;
+    while(n < limit && *what == value && !*(volatile bool*)&rb->closed){
+        YieldProcessor();
+        ++n;
+    }
+    st->spins += n;
+}
+
+// Wake the other side only if it is actually asleep (caller holds cs).
+static void wake_if_asleep(CONDITION_VARIABLE* cv, unsigned asleep, LONGLONG* stamp, RbWaitStats* st){
+    if(!asleep){ ++st->wakeups_skipped; return; }
+    *stamp = qpc_now();
+    ++st->wakeups;
+    WakeConditionVariable(cv);
+}
+
+// Account the notify -> running latency after a park (caller holds cs).
+static void record_wake(LONGLONG stamp, RbWaitStats* st){
+    static LARGE_INTEGER freq;
+    if(!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    uint64_t us = (uint64_t)((qpc_now() - stamp) * 1000000 / freq.QuadPart);
+    ++st->wake_samples;
+    st->wake_total_us += us;
+    if(us > st->wake_max_us) st->wake_max_us = us;
+}
+
 bool rb_init(ByteRing* rb, size_t capacity){
+    return rb_init_node(rb, capacity, -1);
+}
+
+bool rb_init_node(ByteRing* rb, size_t capacity, int numa_node){
     if(!rb || capacity==0) return false;
-    rb->buf = (uint8_t*)malloc(capacity);
+    rb->vmem = false;
+    rb->buf = NULL;
+    if(numa_node >= 0){
+        // committed up front on the reader's node, so first touch can't move it
+        rb->buf = (uint8_t*)VirtualAllocExNuma(GetCurrentProcess(), NULL, capacity,
+                                               MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE, (DWORD)numa_node);
+        rb->vmem = (rb->buf != NULL);
+    }
+    if(!rb->buf) rb->buf = (uint8_t*)malloc(capacity);
     if(!rb->buf) return false;
     rb->cap = capacity;
     rb->head = rb->tail = rb->size = 0;
     rb->closed = false;
+    rb->wait_mode = RB_WAIT_BLOCK;
+    rb->spin_limit = 20000;
+    rb->readers_asleep = rb->writers_asleep = 0;
+    rb->read_wake_qpc = rb->write_wake_qpc = 0;
+    memset(&rb->pop_stats, 0, sizeof rb->pop_stats);
+    memset(&rb->push_stats, 0, sizeof rb->push_stats);
     InitializeCriticalSection(&rb->cs);
     InitializeConditionVariable(&rb->can_read);
     InitializeConditionVariable(&rb->can_write);
@@ -23,11 +76,28 @@ void rb_free(ByteRing* rb){
     uint8_t* p = rb->buf;
     rb->buf=NULL; rb->cap=rb->head=rb->tail=rb->size=0;
     LeaveCriticalSection(&rb->cs);
-    if(p) free(p);
+    if(p){
+        if(rb->vmem) VirtualFree(p, 0, MEM_RELEASE);
+        else free(p);
+    }
     DeleteCriticalSection(&rb->cs);
     // CONDITION_VARIABLE has no destroy API on Windows
 }
 
+void rb_set_wait(ByteRing* rb, RbWaitMode mode, unsigned spin_limit){
+    rb->wait_mode = mode;
+    rb->spin_limit = spin_limit;
+}
+
+const char* rb_wait_name(RbWaitMode mode){
+    switch(mode){
+    case RB_WAIT_BLOCK:     return "block";
+    case RB_WAIT_SPIN:      return "spin";
+    case RB_WAIT_SPIN_PARK: return "spin-then-park";
+    }
+    return "?";
+}
+
 void rb_close(ByteRing* rb){
     EnterCriticalSection(&rb->cs);
     rb->closed = true;
@@ -39,9 +109,16 @@ void rb_close(ByteRing* rb){
 void rb_push_bytes(ByteRing* rb, const uint8_t* src, size_t len){
     size_t off = 0;
     while(off < len){
+        spin_while_equal(rb, &rb->size, rb->cap, &rb->push_stats, false);
         EnterCriticalSection(&rb->cs);
-        while(!rb->closed && rb->size == rb->cap){
-            SleepConditionVariableCS(&rb->can_write, &rb->cs, INFINITE);
+        if(!rb->closed && rb->size == rb->cap){
+            ++rb->push_stats.parks;
+            ++rb->writers_asleep;
+            while(!rb->closed && rb->size == rb->cap){
+                SleepConditionVariableCS(&rb->can_write, &rb->cs, INFINITE);
+            }
+            --rb->writers_asleep;
+            if(!rb->closed) record_wake(rb->write_wake_qpc, &rb->push_stats);
         }
         if(rb->closed){ LeaveCriticalSection(&rb->cs); return; }
 
@@ -65,39 +142,74 @@ void rb_push_bytes(ByteRing* rb, const uint8_t* src, size_t len){
             off += left;
         }
 
-        WakeConditionVariable(&rb->can_read);
+        wake_if_asleep(&rb->can_read, rb->readers_asleep, &rb->read_wake_qpc, &rb->push_stats);
         LeaveCriticalSection(&rb->cs);
     }
 }
 
-void rb_pop_exact(ByteRing* rb, uint8_t* dst, size_t len){
-    size_t out = 0;
-    while(out < len){
-        EnterCriticalSection(&rb->cs);
+// Wait (up to timeout_ms) until at least one byte is available, then copy up
+// to 'max' bytes. Returns 0 when the wait timed out or the ring is closed and
+// drained.
+static size_t pop_chunk(ByteRing* rb, uint8_t* dst, size_t max, DWORD timeout_ms){
+    if(timeout_ms) spin_while_equal(rb, &rb->size, 0, &rb->pop_stats, timeout_ms != INFINITE);
+    EnterCriticalSection(&rb->cs);
+    if(!rb->closed && rb->size == 0 && timeout_ms){
+        ++rb->pop_stats.parks;
+        ++rb->readers_asleep;
         while(!rb->closed && rb->size == 0){
-            SleepConditionVariableCS(&rb->can_read, &rb->cs, INFINITE);
+            if(!SleepConditionVariableCS(&rb->can_read, &rb->cs, timeout_ms) && timeout_ms != INFINITE) break;
         }
-        if(rb->closed && rb->size == 0){ LeaveCriticalSection(&rb->cs); return; }
+        --rb->readers_asleep;
+        if(rb->size) record_wake(rb->read_wake_qpc, &rb->pop_stats);
+    }
+    if(rb->size == 0){ LeaveCriticalSection(&rb->cs); return 0; }
 
-        size_t avail = rb->size;
-        size_t chunk = minz(len - out, avail);
+    size_t chunk = minz(max, rb->size);
 
-        size_t right = rb->cap - rb->tail;
-        size_t first = minz(chunk, right);
-        memcpy(dst + out, rb->buf + rb->tail, first);
-        rb->tail = (rb->tail + first) % rb->cap;
-        rb->size -= first;
-        out += first;
+    size_t right = rb->cap - rb->tail;
+    size_t first = minz(chunk, right);
+    memcpy(dst, rb->buf + rb->tail, first);
+    rb->tail = (rb->tail + first) % rb->cap;
 
-        size_t left = chunk - first;
-        if(left){
-            memcpy(dst + out, rb->buf + rb->tail, left);
-            rb->tail = (rb->tail + left) % rb->cap;
-            rb->size -= left;
-            out += left;
-        }
+    size_t left = chunk - first;
+    if(left){
+        memcpy(dst + first, rb->buf + rb->tail, left);
+        rb->tail = (rb->tail + left) % rb->cap;
+    }
+    rb->size -= chunk;
 
-        WakeConditionVariable(&rb->can_write);
-        LeaveCriticalSection(&rb->cs);
+    wake_if_asleep(&rb->can_write, rb->writers_asleep, &rb->write_wake_qpc, &rb->pop_stats);
+    LeaveCriticalSection(&rb->cs);
+    return chunk;
+}
+
+void rb_pop_exact(ByteRing* rb, uint8_t* dst, size_t len){
+    size_t out = 0;
+    while(out < len){
+        size_t n = pop_chunk(rb, dst + out, len - out, INFINITE);
+        if(!n) return; // closed & drained
+        out += n;
     }
 }
+
+size_t rb_pop_some(ByteRing* rb, uint8_t* dst, size_t max){
+    return max ? pop_chunk(rb, dst, max, INFINITE) : 0;
+}
+
+size_t rb_pop_wait(ByteRing* rb, uint8_t* dst, size_t max, DWORD timeout_ms){
+    return max ? pop_chunk(rb, dst, max, timeout_ms) : 0;
+}
+
+size_t rb_size(ByteRing* rb){
+    EnterCriticalSection(&rb->cs);
+    size_t n = rb->size;
+    LeaveCriticalSection(&rb->cs);
+    return n;
+}
+
+bool rb_drained(ByteRing* rb){
+    EnterCriticalSection(&rb->cs);
+    bool d = rb->closed && rb->size == 0;
+    LeaveCriticalSection(&rb->cs);
+    return d;
+}
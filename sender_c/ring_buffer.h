@@ -4,6 +4,25 @@
 #include <stdbool.h>
 #include <windows.h>
 
+// How a blocked side waits for the other one.
+typedef enum {
+    RB_WAIT_BLOCK = 0,    // sleep on the condition variable right away
+    RB_WAIT_SPIN,         // busy-poll with YieldProcessor(), never sleep
+    RB_WAIT_SPIN_PARK     // poll up to spin_limit times, then sleep
+} RbWaitMode;
+
+// Per-side counters: spins/parks describe how this side waited, wakeups*
+// how often it had to (or could avoid to) signal the other side.
+typedef struct {
+    uint64_t spins;
+    uint64_t parks;
+    uint64_t wakeups;
+    uint64_t wakeups_skipped;
+    uint64_t wake_samples;     // parks ended by a measured wake-up
+    uint64_t wake_total_us;
+    uint64_t wake_max_us;
+} RbWaitStats;
+
 typedef struct {
     uint8_t*         buf;      // storage
     size_t           cap;      // capacity in bytes
@@ -14,15 +33,45 @@ typedef struct {
     CONDITION_VARIABLE can_read;   // signaled when size increases
     CONDITION_VARIABLE can_write;  // signaled when free space increases
     bool             closed;   // true -> wake waiters and stop
+    bool             vmem;     // buf came from VirtualAlloc(ExNuma), not malloc
+
+    RbWaitMode       wait_mode;       // see rb_set_wait()
+    unsigned         spin_limit;
+    unsigned         readers_asleep;  // guarded by cs
+    unsigned         writers_asleep;
+    LONGLONG         read_wake_qpc;   // QPC stamp of the last can_read / can_write wake
+    LONGLONG         write_wake_qpc;
+    RbWaitStats      pop_stats;       // touched by the consumer (or under cs)
+    RbWaitStats      push_stats;      // touched by the producer (or under cs)
 } ByteRing;
 
 bool rb_init(ByteRing* rb, size_t capacity);
+// Same as rb_init, but commits the storage on 'numa_node' (-1 = no preference).
+bool rb_init_node(ByteRing* rb, size_t capacity, int numa_node);
 void rb_free(ByteRing* rb);
 void rb_close(ByteRing* rb);
 
+// Select the wait strategy for both sides (call before the threads start).
+void rb_set_wait(ByteRing* rb, RbWaitMode mode, unsigned spin_limit);
+const char* rb_wait_name(RbWaitMode mode);
+
 // Blocking push: copies ALL 'len' bytes (waits if full).
 void rb_push_bytes(ByteRing* rb, const uint8_t* src, size_t len);
 
 // Blocking pop: waits until at least 'len' bytes are available,
 // then copies them out (FIFO). For us: len = 100.
 void rb_pop_exact(ByteRing* rb, uint8_t* dst, size_t len);
+
+// Blocking pop of whatever is there: waits for at least 1 byte, copies up to
+// 'max'. Returns bytes copied; 0 means closed and drained.
+size_t rb_pop_some(ByteRing* rb, uint8_t* dst, size_t max);
+
+// Like rb_pop_some, but gives up after timeout_ms (0 = don't wait). Returns 0
+// on timeout too; use rb_drained() to tell the two apart.
+size_t rb_pop_wait(ByteRing* rb, uint8_t* dst, size_t max, DWORD timeout_ms);
+
+// Bytes currently buffered (a snapshot).
+size_t rb_size(ByteRing* rb);
+
+// True once the ring is closed and everything was popped.
+bool rb_drained(ByteRing* rb);
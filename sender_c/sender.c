@@ -6,6 +6,10 @@
 #include "reader.h"
 #include "tcp.h"
 #include "packer.h"
+#include "thread_place.h"
+#include "spool.h"
+#include "stripe.h"
+#include "resume.h"
 
 #define RB_CAPACITY (256*1024)
 
@@ -14,33 +18,149 @@
 
 volatile LONG g_running = 1;
 static ByteRing g_rb;
+static Spool g_spool;
+static UdpLink g_udp;
+static StripeSet g_stripes;
+static ResumeWindow g_resume;
+
+static double filetime_sec(FILETIME f){
+    return (double)(((unsigned long long)f.dwHighDateTime << 32) | f.dwLowDateTime) / 1e7;
+}
+
+static double process_cpu_sec(void){
+    FILETIME c, e, k, u;
+    if (!GetProcessTimes(GetCurrentProcess(), &c, &e, &k, &u)) return 0.0;
+    return filetime_sec(k) + filetime_sec(u);
+}
+
+static void print_wait_side(const char* side, const RbWaitStats* st){
+    printf("[ring]   %s: spins %llu, parks %llu, wakeups %llu (skipped %llu), wake latency avg %.1fus max %lluus\n",
+           side, (unsigned long long)st->spins, (unsigned long long)st->parks,
+           (unsigned long long)st->wakeups, (unsigned long long)st->wakeups_skipped,
+           st->wake_samples ? (double)st->wake_total_us / (double)st->wake_samples : 0.0,
+           (unsigned long long)st->wake_max_us);
+}
+
+// Unknown names are rejected (usage) rather than quietly benchmarking 'block'.
+static bool wait_mode_of(const char* w, RbWaitMode* mode){
+    if (!strcmp(w,"block"))    { *mode = RB_WAIT_BLOCK; return true; }
+    if (!strcmp(w,"spin"))     { *mode = RB_WAIT_SPIN; return true; }
+    if (!strcmp(w,"spinpark")) { *mode = RB_WAIT_SPIN_PARK; return true; }
+    return false;
+}
+
+// Same for the spool policy: a typo must not pick the other one.
+static bool spool_policy_of(const char* p, SpoolPolicy* policy){
+    if (!strcmp(p,"behind"))     { *policy = SPOOL_BEHIND; return true; }
+    if (!strcmp(p,"interleave")) { *policy = SPOOL_INTERLEAVE; return true; }
+    return false;
+}
 
 int main(int argc, char** argv) {
     // parse args
     ReaderConfig cfg = {0};
+    ThreadPlacement reader_tp = { "reader", 0, THREAD_PRIORITY_NORMAL };
+    ThreadPlacement packer_tp = { "packer", 0, THREAD_PRIORITY_NORMAL };
+    RbWaitMode wait_mode = RB_WAIT_BLOCK;
+    bool delimited = false;
+    unsigned frame_start = '$', frame_end = '#';
+    size_t frame_len = FRAME_SIZE;
+    unsigned spin_limit = 20000;
+    const char* host = "127.0.0.1";
+    unsigned short port = 5555;
+    const char* spool_path = "sender.spool";
+    unsigned spool_mb = 64, high_pct = 50;
+    SpoolPolicy policy = SPOOL_BEHIND;
+    bool udp = false;
+    unsigned udp_frames = UDP_MAX_FRAMES, source = 0;
+    unsigned stripes = 0, stall_ms = 200;
+    bool resume = false;
+    size_t resume_frames = 65536;
     cfg.baud = BAUD;
     for (int i=1;i<argc;++i){
         if (!strcmp(argv[i],"--com") && i+1<argc){ cfg.use_serial=true; strncpy(cfg.com_name, argv[++i], sizeof cfg.com_name-1); }
         else if (!strcmp(argv[i],"--baud") && i+1<argc){ cfg.baud = (DWORD)strtoul(argv[++i], NULL, 10); }
-        else { printf("Usage: sender.exe [--com COMx] [--baud 115200]\n"); return 0; }
+        else if (!strcmp(argv[i],"--host") && i+1<argc){ host = argv[++i]; }
+        else if (!strcmp(argv[i],"--port") && i+1<argc){ port = (unsigned short)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--udp")){ udp = true; }
+        else if (!strcmp(argv[i],"--udp-frames") && i+1<argc){ udp_frames = (unsigned)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--source") && i+1<argc){ source = (unsigned)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--stripes") && i+1<argc){ stripes = (unsigned)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--stall-ms") && i+1<argc){ stall_ms = (unsigned)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--resume")){ resume = true; }
+        else if (!strcmp(argv[i],"--resume-window") && i+1<argc){ resume_frames = (size_t)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--spool") && i+1<argc){ spool_path = argv[++i]; }
+        else if (!strcmp(argv[i],"--spool-mb") && i+1<argc){ spool_mb = (unsigned)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--spool-at") && i+1<argc){ high_pct = (unsigned)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--spool-policy") && i+1<argc && spool_policy_of(argv[i+1], &policy)){ ++i; }
+        else if (!strcmp(argv[i],"--reader-cpus") && i+1<argc){ reader_tp.cpu_mask = (DWORD_PTR)strtoull(argv[++i], NULL, 0); }
+        else if (!strcmp(argv[i],"--packer-cpus") && i+1<argc){ packer_tp.cpu_mask = (DWORD_PTR)strtoull(argv[++i], NULL, 0); }
+        else if (!strcmp(argv[i],"--reader-prio") && i+1<argc){ reader_tp.priority = atoi(argv[++i]); }
+        else if (!strcmp(argv[i],"--packer-prio") && i+1<argc){ packer_tp.priority = atoi(argv[++i]); }
+        else if (!strcmp(argv[i],"--wait") && i+1<argc && wait_mode_of(argv[i+1], &wait_mode)){ ++i; }
+        else if (!strcmp(argv[i],"--spin") && i+1<argc){ spin_limit = (unsigned)strtoul(argv[++i], NULL, 10); }
+        else if (!strcmp(argv[i],"--delim")){ delimited = true; }
+        else if (!strcmp(argv[i],"--start") && i+1<argc){ frame_start = (unsigned)strtoul(argv[++i], NULL, 0); }
+        else if (!strcmp(argv[i],"--end") && i+1<argc){ frame_end = (unsigned)strtoul(argv[++i], NULL, 0); }
+        else if (!strcmp(argv[i],"--frame-len") && i+1<argc){ frame_len = (size_t)strtoul(argv[++i], NULL, 10); }
+        else {
+            printf("Usage: sender.exe [--com COMx] [--baud 115200] [--host 127.0.0.1] [--port 5555]\n"
+                   "                  [--udp] [--udp-frames 14] [--source 0]\n"
+                   "                  [--stripes N] [--stall-ms 200]\n"
+                   "                  [--resume] [--resume-window 65536]\n"
+                   "                  [--spool sender.spool] [--spool-mb 64] [--spool-at 50]\n"
+                   "                  [--spool-policy behind|interleave]\n"
+                   "                  [--reader-cpus MASK] [--packer-cpus MASK]   e.g. 0x4\n"
+                   "                  [--reader-prio P] [--packer-prio P]         -2..2, 15 = time critical\n"
+                   "                  [--wait block|spin|spinpark] [--spin N]\n"
+                   "                  [--delim] [--start 0x24] [--end 0x23] [--frame-len 100]\n");
+            return 1;
+        }
     }
+    if (delimited && (frame_len < 2 || frame_len > FRAME_SIZE)) {
+        fprintf(stderr, "--frame-len must be 2..%d\n", FRAME_SIZE);
+        return 1;
+    }
+    if ((udp ? 1 : 0) + (stripes ? 1 : 0) + (resume ? 1 : 0) > 1) {
+        fprintf(stderr, "pick one of --udp, --stripes, --resume\n");
+        return 1;
+    }
+    if (resume && !rw_init(&g_resume, resume_frames, FRAME_SIZE)) return 1;
+    Framer framer;
+    framer_init(&framer, (uint8_t)frame_start, (uint8_t)frame_end, frame_len);
 
-    if (!rb_init(&g_rb, RB_CAPACITY)) { fprintf(stderr,"rb_init failed\n"); return 1; }
-    if (!tcp_init()) { fprintf(stderr,"WSAStartup failed\n"); rb_free(&g_rb); return 1; }
-
-    SOCKET sock = tcp_connect("127.0.0.1", 5555);
-    if (sock == INVALID_SOCKET) { tcp_cleanup(); rb_free(&g_rb); return 1; }
-    printf("[main] connected to receiver\n");
+    // The reader is the ring's first writer: keep the ring on its NUMA node.
+    if (!rb_init_node(&g_rb, RB_CAPACITY, thread_place_numa_node(reader_tp.cpu_mask))) { fprintf(stderr,"rb_init failed\n"); rw_free(&g_resume); return 1; }
+    rb_set_wait(&g_rb, wait_mode, spin_limit);
+    // The packer connects (and reconnects) on its own; until then frames go to the spool.
+    if (!spool_open(&g_spool, spool_path, (uint64_t)spool_mb << 20, FRAME_SIZE)) { rb_free(&g_rb); rw_free(&g_resume); return 1; }
+    if (!tcp_init()) { fprintf(stderr,"WSAStartup failed\n"); spool_close(&g_spool); rb_free(&g_rb); rw_free(&g_resume); return 1; }
+    if (udp && !udp_open(&g_udp, host, port, (uint16_t)source, udp_frames, FRAME_SIZE)) {
+        tcp_cleanup(); spool_close(&g_spool); rb_free(&g_rb); rw_free(&g_resume); return 1;
+    }
+    // Striped: the receiver expects every connection before any data, so connect them up front.
+    if (stripes && !stripe_open(&g_stripes, host, port, stripes, FRAME_SIZE, 4096, stall_ms)) {
+        tcp_cleanup(); spool_close(&g_spool); rb_free(&g_rb); rw_free(&g_resume); return 1;
+    }
 
     Reader reader;
-    if (!reader_start(&reader, &cfg, &g_rb, &g_running)) {
-        closesocket(sock); tcp_cleanup(); rb_free(&g_rb); return 1;
+    if (!reader_start(&reader, &cfg, &g_rb, &g_running, &reader_tp)) {
+        if (udp) udp_close(&g_udp);
+        if (stripes) stripe_close(&g_stripes, 0);
+        tcp_cleanup(); spool_close(&g_spool); rb_free(&g_rb); rw_free(&g_resume); return 1;
     }
 
-    PackerArgs pa = { sock, &g_rb };
-    HANDLE hPacker = (HANDLE)_beginthreadex(NULL, 0, packer_thread, &pa, 0, NULL);
+    PackerArgs pa = { host, port, &g_rb, delimited ? &framer : NULL, &g_spool, policy, high_pct,
+                      udp ? &g_udp : NULL, stripes ? &g_stripes : NULL, resume ? &g_resume : NULL };
+    HANDLE hPacker = (HANDLE)_beginthreadex(NULL, 0, packer_thread, &pa, CREATE_SUSPENDED, NULL);
+    thread_place_apply(hPacker, &packer_tp);
+    ResumeThread(hPacker);
 
     puts("Sender running. Press ENTER to stop.");
+    LARGE_INTEGER f, t0, t1;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&t0);
+    double cpu0 = process_cpu_sec();
     getchar();
 
     InterlockedExchange(&g_running, 0);
@@ -48,8 +168,19 @@ int main(int argc, char** argv) {
     reader_join(&reader);
     WaitForSingleObject(hPacker, INFINITE);
     CloseHandle(hPacker);
-    closesocket(sock);
+    if (udp) udp_close(&g_udp);
+    if (stripes) stripe_close(&g_stripes, 2000);
     tcp_cleanup();
+    spool_close(&g_spool);
+    rw_free(&g_resume);
+
+    QueryPerformanceCounter(&t1);
+    double wall = (double)(t1.QuadPart - t0.QuadPart) / (double)f.QuadPart;
+    double cpu = process_cpu_sec() - cpu0;
+    printf("[ring] wait=%s: cpu %.2fs / wall %.2fs (%.0f%%)\n",
+           rb_wait_name(wait_mode), cpu, wall, wall > 0 ? 100.0 * cpu / wall : 0.0);
+    print_wait_side("reader", &g_rb.push_stats);
+    print_wait_side("packer", &g_rb.pop_stats);
     rb_free(&g_rb);
     puts("Sender stopped.");
     return 0;
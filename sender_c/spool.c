@@ -0,0 +1,122 @@
+#include "spool.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SPOOL_HEADER_BYTES 4096
+
+bool spool_open(Spool* sp, const char* path, uint64_t capacity, uint32_t frame){
+    memset(sp, 0, sizeof *sp);
+    capacity -= capacity % frame;
+    if(capacity < frame) capacity = frame;
+
+    sp->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                           OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(sp->file == INVALID_HANDLE_VALUE){
+        fprintf(stderr, "[spool] cannot open %s (%lu)\n", path, GetLastError());
+        sp->file = NULL;
+        return false;
+    }
+
+    // An existing spool keeps its own size so queued frames stay where they are.
+    SpoolHeader old;
+    DWORD got = 0;
+    bool resume = ReadFile(sp->file, &old, sizeof old, &got, NULL) && got == sizeof old &&
+                  old.magic == SPOOL_MAGIC && old.frame == frame && old.cap >= frame &&
+                  old.used <= old.cap && old.head < old.cap && old.tail < old.cap;
+    if(resume) capacity = old.cap;
+
+    uint64_t total = SPOOL_HEADER_BYTES + capacity;
+    sp->map = CreateFileMappingA(sp->file, NULL, PAGE_READWRITE,
+                                 (DWORD)(total >> 32), (DWORD)(total & 0xFFFFFFFFu), NULL);
+    if(sp->map) sp->view = (uint8_t*)MapViewOfFile(sp->map, FILE_MAP_WRITE, 0, 0, (SIZE_T)total);
+    if(!sp->view){
+        fprintf(stderr, "[spool] cannot map %s (%lu)\n", path, GetLastError());
+        spool_close(sp);
+        return false;
+    }
+    sp->hdr = (SpoolHeader*)sp->view;
+    sp->data = sp->view + SPOOL_HEADER_BYTES;
+    if(!resume){
+        memset(sp->hdr, 0, sizeof *sp->hdr);
+        sp->hdr->magic = SPOOL_MAGIC;
+        sp->hdr->frame = frame;
+        sp->hdr->cap = capacity;
+    }
+    printf("[spool] %s: %llu MB, %llu frames queued from earlier runs\n", path,
+           (unsigned long long)(capacity >> 20), (unsigned long long)spool_frames(sp));
+    return true;
+}
+
+void spool_close(Spool* sp){
+    if(sp->view){
+        FlushViewOfFile(sp->view, 0);
+        UnmapViewOfFile(sp->view);
+    }
+    if(sp->map) CloseHandle(sp->map);
+    if(sp->file) CloseHandle(sp->file);
+    sp->view = NULL; sp->map = NULL; sp->file = NULL;
+    sp->hdr = NULL; sp->data = NULL;
+}
+
+// Copy into / out of the circular data area at 'off' (handles the wrap).
+static void ring_copy_in(Spool* sp, uint64_t off, const uint8_t* src, size_t len){
+    size_t first = (size_t)(sp->hdr->cap - off);
+    if(first > len) first = len;
+    memcpy(sp->data + off, src, first);
+    if(len > first) memcpy(sp->data, src + first, len - first);
+}
+
+static void ring_copy_out(Spool* sp, uint64_t off, uint8_t* dst, size_t len){
+    size_t first = (size_t)(sp->hdr->cap - off);
+    if(first > len) first = len;
+    memcpy(dst, sp->data + off, first);
+    if(len > first) memcpy(dst + first, sp->data, len - first);
+}
+
+void spool_append(Spool* sp, const uint8_t* frames, size_t n){
+    SpoolHeader* h = sp->hdr;
+    uint64_t max = h->cap / h->frame;
+    if(n > max){                               // only the newest 'max' frames can fit
+        sp->dropped += n - max;
+        frames += (n - max) * h->frame;
+        n = (size_t)max;
+    }
+    uint64_t len = (uint64_t)n * h->frame;
+    if(h->used + len > h->cap){                // make room: drop the oldest
+        uint64_t drop = h->used + len - h->cap;
+        h->tail = (h->tail + drop) % h->cap;
+        h->used -= drop;
+        sp->dropped += drop / h->frame;
+    }
+    ring_copy_in(sp, h->head, frames, (size_t)len);
+    h->head = (h->head + len) % h->cap;
+    h->used += len;
+    sp->spooled += n;
+}
+
+void spool_unread(Spool* sp, const uint8_t* frames, size_t n){
+    SpoolHeader* h = sp->hdr;
+    uint64_t room = (h->cap - h->used) / h->frame;
+    if(n > room){                              // keep the newest of them, like spool_append
+        sp->dropped += n - room;
+        frames += (n - room) * h->frame;
+        n = (size_t)room;
+    }
+    uint64_t len = (uint64_t)n * h->frame;
+    h->tail = (h->tail + h->cap - len) % h->cap;
+    ring_copy_in(sp, h->tail, frames, (size_t)len);
+    h->used += len;
+}
+
+size_t spool_take(Spool* sp, uint8_t* dst, size_t max_frames){
+    SpoolHeader* h = sp->hdr;
+    if(!h) return 0;
+    size_t n = (size_t)(h->used / h->frame);
+    if(n > max_frames) n = max_frames;
+    size_t len = n * h->frame;
+    ring_copy_out(sp, h->tail, dst, len);
+    h->tail = (h->tail + len) % h->cap;
+    h->used -= len;
+    sp->drained += n;
+    return n;
+}
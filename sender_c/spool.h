@@ -0,0 +1,51 @@
+#pragma once
+#include <windows.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Disk-backed overflow for frames the link can't take right now: a circular
+// log in a memory-mapped file. Head/tail live in the file's first page, so
+// frames that weren't sent before exit (or a crash) are sent on the next run.
+// Single-threaded: only the packer touches it.
+typedef struct {
+    uint32_t magic;        // SPOOL_MAGIC
+    uint32_t frame;        // record size the file was created with
+    uint64_t cap;          // data bytes (multiple of 'frame')
+    uint64_t head;         // next write offset (0..cap-1)
+    uint64_t tail;         // next read offset
+    uint64_t used;         // bytes stored
+} SpoolHeader;
+
+typedef struct {
+    HANDLE       file;
+    HANDLE       map;
+    uint8_t*     view;
+    SpoolHeader* hdr;
+    uint8_t*     data;     // view + header page
+
+    uint64_t     spooled;  // frames written this run
+    uint64_t     drained;  // frames read back this run
+    uint64_t     dropped;  // oldest frames overwritten because the spool was full
+} Spool;
+
+#define SPOOL_MAGIC 0x314C5053u  // "SPL1"
+
+// Create 'path' with room for 'capacity' bytes, or reopen it (keeping its
+// size and any frames still queued). 'frame' is the fixed record size.
+bool spool_open(Spool* sp, const char* path, uint64_t capacity, uint32_t frame);
+void spool_close(Spool* sp);
+
+// Append n whole frames. When full, the oldest frames are overwritten.
+void spool_append(Spool* sp, const uint8_t* frames, size_t n);
+
+// Put n whole frames back in front of the oldest ones, so they are taken
+// next (a batch the link didn't finish). Frames that don't fit are dropped.
+void spool_unread(Spool* sp, const uint8_t* frames, size_t n);
+
+// Copy up to max_frames of the oldest frames into dst and remove them.
+// Returns the number of frames copied.
+size_t spool_take(Spool* sp, uint8_t* dst, size_t max_frames);
+
+static inline bool spool_empty(const Spool* sp) { return !sp->hdr || sp->hdr->used == 0; }
+static inline uint64_t spool_frames(const Spool* sp) { return sp->hdr ? sp->hdr->used / sp->hdr->frame : 0; }
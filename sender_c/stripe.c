@@ -0,0 +1,203 @@
+#include "stripe.h"
+#include "tcp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRIPE_CHUNK 32   // frames queued on one connection before moving to the next
+
+static bool usable(const Stripe* st) { return st->sock != INVALID_SOCKET && !st->stalled; }
+
+// Records start at multiples of rec in buf; off may be inside one.
+static size_t room(const StripeSet* ss, const Stripe* st) {
+    return (ss->cap - (st->len - (st->off - st->off % ss->rec))) / ss->rec;
+}
+
+// Seq of the oldest queued record send() hasn't started on (next_seq if none).
+static uint64_t oldest_seq(const StripeSet* ss, const Stripe* st) {
+    size_t first = (st->off + ss->rec - 1) / ss->rec * ss->rec;
+    uint64_t seq = ss->next_seq;
+    if (first < st->len) memcpy(&seq, st->buf + first, 8);
+    return seq;
+}
+
+// Make room for k more records at the end of st's queue (k <= room()).
+static uint8_t* reserve(StripeSet* ss, Stripe* st, size_t k) {
+    if (st->len + k * ss->rec > ss->cap) {
+        size_t from = st->off - st->off % ss->rec;
+        memmove(st->buf, st->buf + from, st->len - from);
+        st->len -= from;
+        st->off -= from;
+    }
+    uint8_t* p = st->buf + st->len;
+    st->len += k * ss->rec;
+    return p;
+}
+
+// Move the queued whole records of connection i to the usable ones. A record
+// send() already started stays where it is (the receiver needs it whole),
+// unless the connection failed: then the receiver drops the cut-off record
+// and it is resent from the start.
+static void move_queue(StripeSet* ss, unsigned i, bool failed) {
+    Stripe* st = &ss->s[i];
+    size_t first = failed ? st->off - st->off % ss->rec
+                          : (st->off + ss->rec - 1) / ss->rec * ss->rec;
+    if (first >= st->len) return;
+    size_t left = (st->len - first) / ss->rec;
+    const uint8_t* p = st->buf + first;
+    for (unsigned k = 0; k < ss->n && left; ++k) {
+        Stripe* to = &ss->s[(i + 1 + k) % ss->n];
+        if (to == st || !usable(to)) continue;
+        size_t take = room(ss, to);
+        if (take > left) take = left;
+        if (!take) continue;
+        memcpy(reserve(ss, to, take), p, take * ss->rec);
+        p += take * ss->rec;
+        left -= take;
+        ss->moved += take;
+    }
+    // Whatever found no room stays queued here, right after the started record.
+    size_t keep = failed ? 0 : first;
+    memmove(st->buf + keep, p, left * ss->rec);
+    if (failed) { st->off = 0; st->len = left * ss->rec; }
+    else        { st->len = keep + left * ss->rec; }
+}
+
+bool stripe_open(StripeSet* ss, const char* ip, unsigned short port, unsigned n,
+                 size_t frame_size, size_t queue_frames, DWORD stall_ms) {
+    memset(ss, 0, sizeof *ss);
+    ss->n = n < 1 ? 1 : n > STRIPE_MAX ? STRIPE_MAX : n;
+    ss->frame_size = frame_size;
+    ss->rec = 8 + frame_size;
+    ss->cap = (queue_frames ? queue_frames : 1) * ss->rec;
+    ss->stall_ms = stall_ms;
+    for (unsigned i = 0; i < ss->n; ++i) ss->s[i].sock = INVALID_SOCKET;
+
+    for (unsigned i = 0; i < ss->n; ++i) {
+        Stripe* st = &ss->s[i];
+        st->buf = (uint8_t*)malloc(ss->cap);
+        st->sock = st->buf ? tcp_connect(ip, port) : INVALID_SOCKET;
+        uint8_t hello[8];
+        uint32_t magic = STRIPE_MAGIC;
+        memcpy(hello, &magic, 4);
+        hello[4] = (uint8_t)i;      hello[5] = (uint8_t)(i >> 8);
+        hello[6] = (uint8_t)ss->n;  hello[7] = (uint8_t)(ss->n >> 8);
+        if (st->sock == INVALID_SOCKET || !tcp_send_all(st->sock, hello, sizeof hello)) {
+            fprintf(stderr, "[stripe] connection %u to %s:%u failed\n", i, ip, (unsigned)port);
+            stripe_close(ss, 0);
+            return false;
+        }
+        u_long nb = 1;
+        ioctlsocket(st->sock, FIONBIO, &nb);
+    }
+    printf("[stripe] %u connections to %s:%u, stall after %lu ms\n", ss->n, ip, (unsigned)port,
+           (unsigned long)ss->stall_ms);
+    return true;
+}
+
+size_t stripe_send(StripeSet* ss, const uint8_t* frames, size_t n) {
+    size_t done = 0;
+    for (unsigned tries = 0; done < n && tries < ss->n; ) {
+        Stripe* st = &ss->s[ss->rr];
+        size_t k = usable(st) ? room(ss, st) : 0;
+        if (k > STRIPE_CHUNK) k = STRIPE_CHUNK;
+        if (k > n - done) k = n - done;
+        if (!k) { ss->rr = (ss->rr + 1) % ss->n; ++tries; continue; }
+        uint8_t* rec = reserve(ss, st, k);
+        for (size_t j = 0; j < k; ++j, ++done, rec += ss->rec) {
+            uint64_t seq = ss->next_seq++;
+            memcpy(rec, &seq, 8);
+            memcpy(rec + 8, frames + done * ss->frame_size, ss->frame_size);
+        }
+        ss->rr = (ss->rr + 1) % ss->n;
+        tries = 0;
+    }
+    ss->frames += done;
+    return done;
+}
+
+// Records left on a failed connection: retry the move, or drop them once no
+// connection is left to take them.
+static void retry_failed(StripeSet* ss, unsigned i) {
+    Stripe* st = &ss->s[i];
+    if (st->len == st->off) return;
+    if (stripe_alive(ss)) { move_queue(ss, i, true); return; }
+    size_t lost = (st->len - (st->off - st->off % ss->rec)) / ss->rec;
+    fprintf(stderr, "[stripe] all connections down, dropped %zu queued frames\n", lost);
+    ss->dropped += lost;
+    st->off = st->len = 0;
+}
+
+void stripe_pump(StripeSet* ss, DWORD timeout_ms) {
+    DWORD now = GetTickCount();
+    bool waiting = false;
+    fd_set w;
+    FD_ZERO(&w);
+    for (unsigned i = 0; i < ss->n; ++i) {
+        Stripe* st = &ss->s[i];
+        if (st->sock == INVALID_SOCKET) { retry_failed(ss, i); continue; }
+        if (st->off == st->len) continue;
+        int sent = tcp_send_some(st->sock, st->buf + st->off, st->len - st->off, 0);
+        if (sent < 0) {
+            fprintf(stderr, "[stripe] connection %u failed, moving its queue\n", i);
+            closesocket(st->sock);
+            st->sock = INVALID_SOCKET;
+            retry_failed(ss, i);
+            continue;
+        }
+        st->off += (size_t)sent;
+        if (st->off == st->len) {
+            st->off = st->len = 0;
+            st->idle_since = 0;
+            st->stalled = false;   // drained: back in rotation
+            continue;
+        }
+        if (sent > 0 || !st->idle_since) st->idle_since = now ? now : 1;
+        const char* why = NULL;
+        if (!st->stalled && now - st->idle_since >= ss->stall_ms) why = "stalled";
+        else if (!st->stalled && oldest_seq(ss, st) + STRIPE_MAX_LAG < ss->next_seq) why = "falling behind";
+        if (why) {
+            st->stalled = true;
+            ++ss->stalls;
+            fprintf(stderr, "[stripe] connection %u %s, moving its queue\n", i, why);
+            move_queue(ss, i, false);
+        }
+        FD_SET(st->sock, &w);
+        waiting = true;
+    }
+    if (waiting && timeout_ms) {
+        struct timeval tv = { (long)(timeout_ms / 1000), (long)(timeout_ms % 1000) * 1000 };
+        select(0, NULL, &w, NULL, &tv);
+    }
+}
+
+bool stripe_idle(const StripeSet* ss) {
+    for (unsigned i = 0; i < ss->n; ++i)
+        if (ss->s[i].off != ss->s[i].len) return false;
+    return true;
+}
+
+bool stripe_alive(const StripeSet* ss) {
+    for (unsigned i = 0; i < ss->n; ++i)
+        if (ss->s[i].sock != INVALID_SOCKET) return true;
+    return false;
+}
+
+void stripe_close(StripeSet* ss, DWORD timeout_ms) {
+    DWORD start = GetTickCount();
+    while (timeout_ms && !stripe_idle(ss) && GetTickCount() - start < timeout_ms) stripe_pump(ss, 10);
+    for (unsigned i = 0; i < ss->n; ++i) {   // still queued after the timeout: never sent
+        Stripe* st = &ss->s[i];
+        if (st->buf && st->len > st->off) ss->dropped += (st->len - (st->off - st->off % ss->rec)) / ss->rec;
+    }
+    if (ss->frames)
+        printf("[stripe] %llu frames, %llu moved off stalled/failed connections (%llu stalls), %llu dropped\n",
+               (unsigned long long)ss->frames, (unsigned long long)ss->moved, (unsigned long long)ss->stalls,
+               (unsigned long long)ss->dropped);
+    for (unsigned i = 0; i < ss->n; ++i) {
+        if (ss->s[i].sock != INVALID_SOCKET) closesocket(ss->s[i].sock);
+        ss->s[i].sock = INVALID_SOCKET;
+        free(ss->s[i].buf);
+        ss->s[i].buf = NULL;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <winsock2.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// One stream striped over several TCP connections (receiver --striped).
+// Every connection opens with a hello {u32 'STRP', u16 index, u16 count}
+// and then carries records of u64 seq + one frame, seq being global. The
+// receiver puts them back in order.
+//
+// Each connection has its own send queue. New frames go to the connections
+// that are keeping up. A connection whose queue makes no progress for
+// stall_ms, or whose oldest queued frame is more than STRIPE_MAX_LAG frames
+// behind the newest one, is marked stalled: its queued whole frames move to
+// the others and it gets nothing new until it has drained. A connection that
+// fails has its queue moved the same way; what finds no room is moved on a
+// later pump, and dropped (and counted) only once no connection is left.
+#define STRIPE_MAGIC 0x50525453u   // "STRP"
+#define STRIPE_MAX   16
+#define STRIPE_MAX_LAG 4096        // well inside the receiver's STRIPE_REORDER_WINDOW (16384)
+
+typedef struct {
+    SOCKET   sock;          // INVALID_SOCKET once the connection failed
+    uint8_t* buf;           // queued records
+    size_t   len, off;      // bytes queued / already handed to send()
+    DWORD    idle_since;    // GetTickCount() since the queue last moved, 0 = moving
+    bool     stalled;
+} Stripe;
+
+typedef struct {
+    Stripe   s[STRIPE_MAX];
+    unsigned n;
+    size_t   frame_size;
+    size_t   rec;           // 8 + frame_size
+    size_t   cap;           // queue bytes per connection
+    DWORD    stall_ms;
+    unsigned rr;            // next connection to fill
+    uint64_t next_seq;
+    uint64_t frames, moved, stalls, dropped;
+} StripeSet;
+
+// Connect n (1..STRIPE_MAX) connections to ip:port and send the hellos.
+bool stripe_open(StripeSet* ss, const char* ip, unsigned short port, unsigned n,
+                 size_t frame_size, size_t queue_frames, DWORD stall_ms);
+
+// Give up to the connections (or until timeout_ms) what is queued, then close them.
+void stripe_close(StripeSet* ss, DWORD timeout_ms);
+
+// Tag n frames with the next seqs and queue them. Returns how many were taken:
+// fewer than n when every usable queue is full.
+size_t stripe_send(StripeSet* ss, const uint8_t* frames, size_t n);
+
+// Push queued bytes without blocking longer than timeout_ms; detects stalls
+// and failures and moves their frames.
+void stripe_pump(StripeSet* ss, DWORD timeout_ms);
+
+bool stripe_idle(const StripeSet* ss);    // nothing queued anywhere (failed connections included)
+bool stripe_alive(const StripeSet* ss);   // at least one connection left
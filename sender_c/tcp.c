@@ -1,5 +1,6 @@
 #include "tcp.h"
 #include <stdio.h>
+#include <string.h>
 
 bool tcp_init(void) {
     WSADATA w; return (WSAStartup(MAKEWORD(2,2), &w) == 0);
@@ -24,3 +25,144 @@ bool tcp_send_all(SOCKET s, const void* buf, size_t len) {
     }
     return true;
 }
+
+SOCKET tcp_connect_timeout(const char* ip, unsigned short port, DWORD timeout_ms) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    struct sockaddr_in a; memset(&a, 0, sizeof a);
+    a.sin_family = AF_INET; a.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip, &a.sin_addr) != 1) { closesocket(s); return INVALID_SOCKET; }
+
+    u_long nb = 1;
+    ioctlsocket(s, FIONBIO, &nb);
+    if (connect(s, (struct sockaddr*)&a, sizeof a) == 0) return s;
+    if (WSAGetLastError() != WSAEWOULDBLOCK) { closesocket(s); return INVALID_SOCKET; }
+
+    fd_set w, e; FD_ZERO(&w); FD_ZERO(&e); FD_SET(s, &w); FD_SET(s, &e);
+    struct timeval tv = { (long)(timeout_ms / 1000), (long)(timeout_ms % 1000) * 1000 };
+    if (select(0, NULL, &w, &e, &tv) != 1 || !FD_ISSET(s, &w)) { closesocket(s); return INVALID_SOCKET; }
+    return s;
+}
+
+int tcp_send_some(SOCKET s, const void* buf, size_t len, DWORD timeout_ms) {
+    const char* p = (const char*)buf; size_t off = 0;
+    while (off < len) {
+        int n = send(s, p + off, (int)(len - off), 0);
+        if (n > 0) { off += (size_t)n; continue; }
+        if (n == SOCKET_ERROR && WSAGetLastError() != WSAEWOULDBLOCK) return -1;
+        if (!timeout_ms) break;
+        fd_set w; FD_ZERO(&w); FD_SET(s, &w);
+        struct timeval tv = { (long)(timeout_ms / 1000), (long)(timeout_ms % 1000) * 1000 };
+        if (select(0, NULL, &w, NULL, &tv) <= 0) break;   // still full: report progress so far
+    }
+    return (int)off;
+}
+
+int tcp_recv_some(SOCKET s, void* buf, size_t len, DWORD timeout_ms) {
+    for (;;) {
+        int n = recv(s, (char*)buf, (int)len, 0);
+        if (n > 0) return n;
+        if (n == 0 || WSAGetLastError() != WSAEWOULDBLOCK) return -1;
+        if (!timeout_ms) return 0;
+        fd_set r; FD_ZERO(&r); FD_SET(s, &r);
+        struct timeval tv = { (long)(timeout_ms / 1000), (long)(timeout_ms % 1000) * 1000 };
+        if (select(0, &r, NULL, NULL, &tv) <= 0) return 0;
+        timeout_ms = 0;   // readable: one more try
+    }
+}
+
+bool udp_open(UdpLink* u, const char* ip, unsigned short port, uint16_t source,
+              unsigned frames_per_dgram, size_t frame_size) {
+    memset(u, 0, sizeof *u);
+    u->source = source;
+    u->frame_size = frame_size;
+    u->frames_per_dgram = frames_per_dgram < 1 ? 1 : frames_per_dgram > UDP_MAX_FRAMES ? UDP_MAX_FRAMES : frames_per_dgram;
+    u->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (u->sock == INVALID_SOCKET) { fprintf(stderr, "[udp] socket failed\n"); return false; }
+    struct sockaddr_in a; memset(&a, 0, sizeof a);
+    a.sin_family = AF_INET; a.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip, &a.sin_addr) != 1 || connect(u->sock, (struct sockaddr*)&a, sizeof a) != 0) {
+        fprintf(stderr, "[udp] bad address %s:%u\n", ip, (unsigned)port);
+        closesocket(u->sock);
+        u->sock = INVALID_SOCKET;
+        return false;
+    }
+    int sndbuf = 4 * 1024 * 1024;
+    setsockopt(u->sock, SOL_SOCKET, SO_SNDBUF, (const char*)&sndbuf, sizeof sndbuf);
+
+    GUID id = WSAID_TRANSMITPACKETS;
+    DWORD got = 0;
+    if (WSAIoctl(u->sock, SIO_GET_EXTENSION_FUNCTION_POINTER, &id, sizeof id,
+                 &u->transmit, sizeof u->transmit, &got, NULL, NULL) != 0)
+        u->transmit = NULL;
+    printf("[udp] %s:%u, source %u, %u frames per datagram, %s\n", ip, (unsigned)port, (unsigned)source,
+           u->frames_per_dgram, u->transmit ? "TransmitPackets" : "WSASend");
+    return true;
+}
+
+void udp_close(UdpLink* u) {
+    if (u->sock == INVALID_SOCKET) return;
+    printf("[udp] %llu datagrams in %llu calls, %llu failed calls\n", (unsigned long long)u->datagrams,
+           (unsigned long long)u->calls, (unsigned long long)u->errors);
+    closesocket(u->sock);
+    u->sock = INVALID_SOCKET;
+}
+
+// Queue datagram d: its header, then its frames (none for the end marker).
+// Returns the next free element index.
+static DWORD udp_add(UdpLink* u, DWORD d, DWORD e, uint32_t seq, const uint8_t* frames, size_t n) {
+    UdpHeader* h = &u->hdr[d];
+    h->magic = UDP_MAGIC;
+    h->source = u->source;
+    h->seq = seq;
+    u->el[e].dwElFlags = n ? TP_ELEMENT_MEMORY : TP_ELEMENT_MEMORY | TP_ELEMENT_EOP;
+    u->el[e].cLength = sizeof *h;
+    u->el[e].pBuffer = h;
+    if (!n) return e + 1;
+    u->el[e + 1].dwElFlags = TP_ELEMENT_MEMORY | TP_ELEMENT_EOP;
+    u->el[e + 1].cLength = (ULONG)(n * u->frame_size);
+    u->el[e + 1].pBuffer = (PVOID)frames;
+    return e + 2;
+}
+
+// Push u->el[0..e) out as d datagrams.
+static void udp_flush(UdpLink* u, DWORD d, DWORD e) {
+    ++u->calls;
+    u->datagrams += d;
+    if (u->transmit) {
+        if (u->transmit(u->sock, u->el, e, 0, NULL, 0)) return;
+        fprintf(stderr, "[udp] TransmitPackets failed (%d), using WSASend\n", WSAGetLastError());
+        u->transmit = NULL;
+    }
+    for (DWORD i = 0; i < e;) {
+        WSABUF b[2];
+        DWORD nb = 0, sent = 0;
+        do {
+            b[nb].buf = (char*)u->el[i].pBuffer;
+            b[nb].len = u->el[i].cLength;
+            ++nb;
+        } while (!(u->el[i++].dwElFlags & TP_ELEMENT_EOP));
+        if (WSASend(u->sock, b, nb, &sent, 0, NULL, NULL) != 0) { ++u->errors; return; }
+    }
+}
+
+void udp_send_frames(UdpLink* u, const uint8_t* frames, size_t n) {
+    while (n) {
+        DWORD d = 0, e = 0;
+        for (; n && d < UDP_BATCH; ++d) {
+            size_t k = n < u->frames_per_dgram ? n : u->frames_per_dgram;
+            e = udp_add(u, d, e, u->seq++, frames, k);
+            frames += k * u->frame_size;
+            n -= k;
+        }
+        udp_flush(u, d, e);
+    }
+}
+
+void udp_send_end(UdpLink* u) {
+    uint32_t seq = u->seq++;
+    for (int i = 0; i < 3; ++i) {
+        udp_flush(u, 1, udp_add(u, 0, 0, seq, NULL, 0));
+        Sleep(1);
+    }
+}
@@ -1,7 +1,9 @@
 #pragma once
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <mswsock.h>
 #include <stdbool.h>
+#include <stdint.h>
 #pragma comment(lib,"ws2_32.lib")
 
 bool tcp_init(void);
@@ -10,5 +12,57 @@ void tcp_cleanup(void);
 // Connect to ip:port (e.g., "127.0.0.1", 5555). Returns INVALID_SOCKET on fail.
 SOCKET tcp_connect(const char* ip, unsigned short port);
 
+// Non-blocking connect that gives up after timeout_ms. The socket is left in
+// non-blocking mode (use tcp_send_some). Returns INVALID_SOCKET quietly on failure.
+SOCKET tcp_connect_timeout(const char* ip, unsigned short port, DWORD timeout_ms);
+
+// Send as much of buf as the connection takes within timeout_ms (0 = no
+// waiting). Returns bytes sent, or -1 if the connection failed.
+int tcp_send_some(SOCKET s, const void* buf, size_t len, DWORD timeout_ms);
+
+// Receive up to len bytes on a non-blocking socket, waiting up to timeout_ms
+// for the first one. Returns bytes received (0 = nothing yet), or -1 if the
+// connection failed or was closed.
+int tcp_recv_some(SOCKET s, void* buf, size_t len, DWORD timeout_ms);
+
 // Send exactly len bytes (loops until done). Returns false on error.
 bool tcp_send_all(SOCKET s, const void* buf, size_t len);
+
+// ---- UDP (receiver --udp) ----
+// Datagram: UdpHeader, then 1..UDP_MAX_FRAMES frames. A header with no frames
+// ends this source's stream. seq counts datagrams, so the receiver can count
+// gaps per source.
+#define UDP_MAGIC      0x5055   // "UP"
+#define UDP_MAX_FRAMES 14       // 8 + 14 * 100 = 1408 bytes: fits a 1500-byte MTU
+#define UDP_BATCH      64       // datagrams per TransmitPackets call
+
+typedef struct {
+    uint16_t magic;
+    uint16_t source;
+    uint32_t seq;
+} UdpHeader;                    // 8 bytes, little-endian on the wire
+
+typedef struct {
+    SOCKET    sock;
+    uint16_t  source;
+    uint32_t  seq;
+    unsigned  frames_per_dgram;
+    size_t    frame_size;
+    LPFN_TRANSMITPACKETS transmit;               // NULL: one WSASend per datagram
+    UdpHeader hdr[UDP_BATCH];
+    TRANSMIT_PACKETS_ELEMENT el[2 * UDP_BATCH];  // header + frames per datagram
+    uint64_t  datagrams, calls, errors;
+} UdpLink;
+
+// Connected UDP socket to ip:port. frames_per_dgram is clamped to 1..UDP_MAX_FRAMES.
+bool udp_open(UdpLink* u, const char* ip, unsigned short port, uint16_t source,
+              unsigned frames_per_dgram, size_t frame_size);
+void udp_close(UdpLink* u);
+
+// Send n frames as datagrams of up to frames_per_dgram frames, UDP_BATCH
+// datagrams per call (TransmitPackets, one datagram per TP_ELEMENT_EOP).
+// Never blocks on the receiver: a failed call only bumps 'errors'.
+void udp_send_frames(UdpLink* u, const uint8_t* frames, size_t n);
+
+// End-of-stream marker (sent a few times, UDP may drop one).
+void udp_send_end(UdpLink* u);
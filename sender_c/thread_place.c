@@ -0,0 +1,60 @@
+#include "thread_place.h"
+#include <stdio.h>
+
+// SetThreadDescription exists from Windows 10 1607; look it up at runtime.
+typedef HRESULT (WINAPI *SetThreadDescriptionFn)(HANDLE, PCWSTR);
+
+static bool set_thread_name(HANDLE th, const char* name)
+{
+    static SetThreadDescriptionFn fn = NULL;
+    static bool looked_up = false;
+    wchar_t wname[64];
+
+    if (!looked_up) {
+        fn = (SetThreadDescriptionFn)(void*)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+        looked_up = true;
+    }
+    if (!fn || !name) return false;
+    if (!MultiByteToWideChar(CP_UTF8, 0, name, -1, wname, 64)) return false;
+    return SUCCEEDED(fn(th, wname));
+}
+
+int thread_place_numa_node(DWORD_PTR cpu_mask)
+{
+    UCHAR node = 0;
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (!(cpu_mask & ((DWORD_PTR)1 << cpu))) continue;
+        if (!GetNumaProcessorNode((UCHAR)cpu, &node) || node == 0xFF) return -1;
+        return node;
+    }
+    return -1;
+}
+
+bool thread_place_apply(HANDLE th, const ThreadPlacement* tp)
+{
+    const char* tag = (tp && tp->name) ? tp->name : "thread";
+    bool ok = true;
+    if (!tp) return true;
+
+    bool named = set_thread_name(th, tp->name);
+
+    if (tp->cpu_mask && !SetThreadAffinityMask(th, tp->cpu_mask)) {
+        fprintf(stderr, "[place] %s: SetThreadAffinityMask(0x%llx) failed (%lu)\n",
+                tag, (unsigned long long)tp->cpu_mask, GetLastError());
+        ok = false;
+    }
+    if (tp->priority != THREAD_PRIORITY_NORMAL && !SetThreadPriority(th, tp->priority)) {
+        fprintf(stderr, "[place] %s: SetThreadPriority(%d) failed (%lu)\n",
+                tag, tp->priority, GetLastError());
+        ok = false;
+    }
+
+    // Report what is in effect, not what was asked for.
+    GROUP_AFFINITY ga;
+    ZeroMemory(&ga, sizeof ga);
+    DWORD_PTR mask = GetThreadGroupAffinity(th, &ga) ? (DWORD_PTR)ga.Mask : 0;
+    printf("[place] %s: cpus 0x%llx, priority %d, numa node %d%s\n",
+           tag, (unsigned long long)mask, GetThreadPriority(th),
+           thread_place_numa_node(mask), named ? "" : " (unnamed)");
+    return ok;
+}
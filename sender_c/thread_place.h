@@ -0,0 +1,17 @@
+#pragma once
+#include <windows.h>
+#include <stdbool.h>
+
+// Where and how a worker thread runs. Zeroed struct = leave it to the scheduler.
+typedef struct {
+    const char* name;      // thread description (debugger / ETW), may be NULL
+    DWORD_PTR   cpu_mask;  // affinity mask in processor group 0; 0 = any CPU
+    int         priority;  // THREAD_PRIORITY_*; TIME_CRITICAL is the closest to SCHED_FIFO
+} ThreadPlacement;
+
+// Apply name/affinity/priority to 'th' (ideally created CREATE_SUSPENDED) and
+// print what the OS actually accepted. Returns false if a setting was rejected.
+bool thread_place_apply(HANDLE th, const ThreadPlacement* tp);
+
+// NUMA node of the lowest CPU in 'cpu_mask'; -1 if empty or unknown.
+int thread_place_numa_node(DWORD_PTR cpu_mask);